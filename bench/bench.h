@@ -0,0 +1,72 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * bench.h: timing and results of the benchmarks
+ *
+ * Besides its table on the standard output, each benchmark appends its
+ * measures to the file named by the BENCH_RESULTS environment variable,
+ * if set, one JSON line per measure, like
+ *
+ *   {"bench":"bench_crc","input":"sample.dwg","metric":"load",
+ *    "value":1.234,"unit":"ms"}
+ *
+ * (on one line), for the results of runs to be compared.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+static double
+now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* Append the measure value of metric, in unit, for input of the
+ * benchmark bench to the results file, if any.
+ */
+static void
+bench_record(const char *bench, const char *input, const char *metric,
+             double value, const char *unit)
+{
+  const char *path = getenv("BENCH_RESULTS");
+  const char *base;
+  FILE *fp;
+
+  if (!path || !*path)
+    return;
+  fp = fopen(path, "a");
+  if (!fp)
+    {
+      perror(path);
+      return;
+    }
+  base = strrchr(bench, '/');
+  bench = base ? base + 1 : bench;
+  base = strrchr(input, '/');
+  input = base ? base + 1 : input;
+  fprintf(fp, "{\"bench\":\"%s\",\"input\":\"%s\",\"metric\":\"%s\","
+          "\"value\":%.6g,\"unit\":\"%s\"}\n", bench, input, metric, value,
+          unit);
+  fclose(fp);
+}
+
+#endif
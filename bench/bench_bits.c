@@ -0,0 +1,368 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * bench_bits.c: throughput of the bit_read_* and bit_write_* primitives
+ *
+ * For each primitive, an R2000 chain is filled with COUNT values by its
+ * writer, then read back by its reader, each value being checked.  The
+ * values are pseudo-random, but of random widths, so that the short
+ * codes of the bit shorts, longs and doubles are as taken as the long
+ * ones; the defaults of the bit doubles with default are the value with
+ * 0, 2, 4 or 8 of its bytes changed, for the four codes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bits.h"
+#include "bench.h"
+
+/* Values per pass */
+#define COUNT (1 << 18)
+
+/* Largest value written, in bytes */
+#define MAX_BYTES 40
+
+/* Values per measure */
+#define MIN_VALUES (8 * 1024 * 1024)
+
+static long unsigned int ints[COUNT];
+static double doubles[COUNT];
+static double defaults[COUNT];
+
+static char *texts[] = {
+  "", "0", "Standard", "ByLayer", "*Model_Space", "ACAD_GROUP",
+  "A somewhat longer text, as of an MTEXT entity", "CONTINUOUS"
+};
+
+typedef void (*Write_Function) (Bit_Chain *dat, unsigned long int i);
+
+/* Read value i, returning whether it differs from the written one.  */
+typedef int (*Read_Function) (Bit_Chain *dat, unsigned long int i);
+
+typedef struct _primitive
+{
+  const char *name;
+  Write_Function write;
+  Read_Function read;
+} Primitive;
+
+static long unsigned int
+random64(void)
+{
+  static long unsigned int state = 88172645463325252UL;
+
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+/* Set byte i of the 8 bytes of x to that of y.  */
+static double
+replace_bytes(double x, double y, int from, int to)
+{
+  unsigned char a[8], b[8];
+
+  memcpy(a, &x, 8);
+  memcpy(b, &y, 8);
+  memcpy(a + from, b + from, to - from);
+  memcpy(&x, a, 8);
+  return x;
+}
+
+static void
+init_values(void)
+{
+  long unsigned int r;
+  double other;
+  int i;
+
+  for (i = 0; i < COUNT; i++)
+    {
+      r = random64();
+      ints[i] = (r >> 32) >> (r & 31);
+      r = random64();
+      switch (i & 3)
+        {
+        case 0:
+          doubles[i] = 0.0;
+          break;
+        case 1:
+          doubles[i] = 1.0;
+          break;
+        default:
+          doubles[i] = ((r >> 11) * (1.0 / (1UL << 53)) - 0.5) * 2000.0;
+        }
+      other = ((random64() >> 11) * (1.0 / (1UL << 53)) - 0.5) * 2000.0;
+      switch (r & 3)
+        {
+        case 0:
+          defaults[i] = doubles[i];
+          break;
+        case 1:
+          defaults[i] = replace_bytes(doubles[i], other, 0, 2);
+          break;
+        case 2:
+          defaults[i] = replace_bytes(doubles[i], other, 0, 4);
+          break;
+        default:
+          defaults[i] = other;
+        }
+    }
+}
+
+/* The primitives
+ */
+
+#define INTEGER(name, mask) \
+static void \
+write_##name(Bit_Chain *dat, unsigned long int i) \
+{ \
+  bit_write_##name(dat, ints[i] & (mask)); \
+} \
+static int \
+read_##name(Bit_Chain *dat, unsigned long int i) \
+{ \
+  return (bit_read_##name(dat) & (mask)) != (ints[i] & (mask)); \
+}
+
+#define DOUBLE(name) \
+static void \
+write_##name(Bit_Chain *dat, unsigned long int i) \
+{ \
+  bit_write_##name(dat, doubles[i]); \
+} \
+static int \
+read_##name(Bit_Chain *dat, unsigned long int i) \
+{ \
+  return bit_read_##name(dat) != doubles[i]; \
+}
+
+INTEGER(B, 1)
+INTEGER(BB, 3)
+INTEGER(4BITS, 0xF)
+INTEGER(RC, 0xFF)
+INTEGER(RS, 0xFFFF)
+INTEGER(RL, 0xFFFFFFFF)
+INTEGER(BS, 0xFFFF)
+INTEGER(BL, 0xFFFFFFFF)
+INTEGER(MS, 0x7FFF)
+INTEGER(L, 0xFFFFFFFF)
+DOUBLE(RD)
+DOUBLE(BD)
+DOUBLE(BT)
+
+/* Negative for odd i */
+static long int
+mc_value(unsigned long int i)
+{
+  long int value = ints[i] & 0x7FFFFFF;
+
+  return i & 1 ? -value : value;
+}
+
+static void
+write_MC(Bit_Chain *dat, unsigned long int i)
+{
+  bit_write_MC(dat, mc_value(i));
+}
+
+static int
+read_MC(Bit_Chain *dat, unsigned long int i)
+{
+  return bit_read_MC(dat) != mc_value(i);
+}
+
+/* The default extrusion for i a multiple of 4 */
+static void
+write_BE(Bit_Chain *dat, unsigned long int i)
+{
+  if (i & 3)
+    bit_write_BE(dat, doubles[i], doubles[i ^ 1], doubles[i ^ 2]);
+  else
+    bit_write_BE(dat, 0.0, 0.0, 1.0);
+}
+
+static int
+read_BE(Bit_Chain *dat, unsigned long int i)
+{
+  double x, y, z;
+
+  bit_read_BE(dat, &x, &y, &z);
+  if (i & 3)
+    return x != doubles[i] || y != doubles[i ^ 1] || z != doubles[i ^ 2];
+  return x != 0.0 || y != 0.0 || z != 1.0;
+}
+
+static void
+write_DD(Bit_Chain *dat, unsigned long int i)
+{
+  bit_write_DD(dat, doubles[i], defaults[i]);
+}
+
+static int
+read_DD(Bit_Chain *dat, unsigned long int i)
+{
+  return bit_read_DD(dat, defaults[i]) != doubles[i];
+}
+
+static void
+write_H(Bit_Chain *dat, unsigned long int i)
+{
+  Dwg_Handle handle;
+
+  handle.code = ints[i ^ 1] & 0xF;
+  handle.value = ints[i] & 0xFFFFFFFF;
+  bit_write_H(dat, &handle);
+}
+
+static int
+read_H(Bit_Chain *dat, unsigned long int i)
+{
+  Dwg_Handle handle;
+
+  return bit_read_H(dat, &handle) || handle.code != (ints[i ^ 1] & 0xF)
+    || handle.value != (ints[i] & 0xFFFFFFFF);
+}
+
+static void
+write_TV(Bit_Chain *dat, unsigned long int i)
+{
+  bit_write_TV(dat, (unsigned char *) texts[i & 7]);
+}
+
+static int
+read_TV(Bit_Chain *dat, unsigned long int i)
+{
+  unsigned char *text = bit_read_TV(dat);
+  int differs;
+
+  differs = strcmp((char *) text, texts[i & 7]) != 0;
+  free(text);
+  return differs;
+}
+
+static void
+write_CMC(Bit_Chain *dat, unsigned long int i)
+{
+  Dwg_Color color;
+
+  memset(&color, 0, sizeof(color));
+  color.index = ints[i] & 0xFFFF;
+  bit_write_CMC(dat, &color);
+}
+
+static int
+read_CMC(Bit_Chain *dat, unsigned long int i)
+{
+  Dwg_Color color;
+
+  bit_read_CMC(dat, &color);
+  return color.index != (ints[i] & 0xFFFF);
+}
+
+#define PRIMITIVE(name) { #name, write_##name, read_##name }
+
+static Primitive primitives[] = {
+  PRIMITIVE(B), PRIMITIVE(BB), PRIMITIVE(4BITS), PRIMITIVE(RC),
+  PRIMITIVE(RS), PRIMITIVE(RL), PRIMITIVE(RD), PRIMITIVE(BS),
+  PRIMITIVE(BL), PRIMITIVE(BD), PRIMITIVE(MC), PRIMITIVE(MS),
+  PRIMITIVE(BE), PRIMITIVE(DD), PRIMITIVE(BT), PRIMITIVE(H),
+  PRIMITIVE(TV), PRIMITIVE(L), PRIMITIVE(CMC)
+};
+
+/* Benchmark
+ */
+
+/* Write all values into dat until MIN_VALUES are written, and return the
+ * throughput in millions of values per second.
+ */
+static double
+measure_write(Primitive *primitive, Bit_Chain *dat)
+{
+  unsigned long int total = 0, i;
+  double start = now();
+
+  while (total < MIN_VALUES)
+    {
+      dat->byte = 0;
+      dat->bit = 0;
+      for (i = 0; i < COUNT; i++)
+        primitive->write(dat, i);
+      total += COUNT;
+    }
+  return total / (now() - start) / 1e6;
+}
+
+/* Read the values back, as measure_write, or return -1 if one differs.
+ */
+static double
+measure_read(Primitive *primitive, Bit_Chain *dat)
+{
+  unsigned long int total = 0, i;
+  double start = now();
+
+  while (total < MIN_VALUES)
+    {
+      dat->byte = 0;
+      dat->bit = 0;
+      for (i = 0; i < COUNT; i++)
+        if (primitive->read(dat, i))
+          return -1;
+      total += COUNT;
+    }
+  return total / (now() - start) / 1e6;
+}
+
+int
+main(int argc, char *argv[])
+{
+  Bit_Chain dat;
+  unsigned int i;
+  double write, read;
+  char metric[32];
+  int error = 0;
+
+  (void) argc;
+  memset(&dat, 0, sizeof(dat));
+  dat.version = R_2000;
+  dat.size = COUNT * MAX_BYTES;
+  dat.chain = (unsigned char *) calloc(dat.size, 1);
+  if (!dat.chain)
+    {
+      fprintf(stderr, "Out of memory\n");
+      return 1;
+    }
+  init_values();
+
+  printf("%-10s %14s %14s\n", "primitive", "write Mval/s", "read Mval/s");
+  for (i = 0; i < sizeof(primitives) / sizeof(Primitive); i++)
+    {
+      write = measure_write(&primitives[i], &dat);
+      read = measure_read(&primitives[i], &dat);
+      printf("%-10s %14.1f %14.1f\n", primitives[i].name, write, read);
+      sprintf(metric, "write_%s", primitives[i].name);
+      bench_record(argv[0], "random", metric, write, "Mval/s");
+      sprintf(metric, "read_%s", primitives[i].name);
+      bench_record(argv[0], "random", metric, read, "Mval/s");
+      if (read < 0)
+        {
+          fprintf(stderr, "%s: read value differs\n", primitives[i].name);
+          error = 1;
+        }
+    }
+  free(dat.chain);
+  return error;
+}
@@ -0,0 +1,169 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * bench_crc.c: throughput of the section CRC, and load time without it
+ *
+ * bit_ckr8 runs over each file in chunks of the size of the object map
+ * sections, and, for reference, the byte at a time CRC it replaced, kept
+ * below; both results are compared.  Then the file is loaded with and
+ * without DWG_OPT_NO_CRC.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dwg.h>
+#include "bench.h"
+
+/* Largest section of the object map */
+#define CHUNK_SIZE 2032
+
+/* Passes over the data per measure */
+#define MIN_BYTES (256 * 1024 * 1024)
+
+/* Loads per measure */
+#define LOADS 200
+
+unsigned int
+bit_ckr8(unsigned int dx, unsigned char *adr, long n);
+
+typedef unsigned int (*Ckr_Function) (unsigned int dx, unsigned char *adr,
+                                      long n);
+
+/* The byte at a time CRC, with the table built on first use.  */
+static unsigned int
+ref_ckr8(unsigned int dx, unsigned char *adr, long n)
+{
+  static unsigned int table[256];
+  unsigned int i, j, c;
+
+  if (!table[1])
+    for (i = 0; i < 256; i++)
+      {
+        for (c = i, j = 0; j < 8; j++)
+          c = c & 1 ? (c >> 1) ^ 0xA001 : c >> 1;
+        table[i] = c;
+      }
+  for (; n > 0; n--, adr++)
+    dx = ((dx >> 8) & 0xFF) ^ table[(*adr ^ dx) & 0xFF];
+  return dx;
+}
+
+/* Run ckr over data in chunks until MIN_BYTES are done, and return the
+ * throughput in MB/s, and in sum the sum of the CRCs of one pass.
+ */
+static double
+measure(Ckr_Function ckr, unsigned char *data, long int size,
+        unsigned long int *sum)
+{
+  unsigned long int total = 0;
+  double start = now();
+  long int i, n;
+
+  while (total < MIN_BYTES)
+    {
+      *sum = 0;
+      for (i = 0; i < size; i += n)
+        {
+          n = size - i < CHUNK_SIZE ? size - i : CHUNK_SIZE;
+          *sum += ckr(0xC0C1, data + i, n);
+        }
+      total += size;
+    }
+  return total / (now() - start) / 1e6;
+}
+
+/* Load the file LOADS times with the flags, and return the time of one
+ * load in ms, or -1.
+ */
+static double
+measure_load(unsigned char *data, long int size, unsigned int flags)
+{
+  Dwg_Read_Options options;
+  Dwg_Data dwg;
+  double start = now();
+  int i;
+
+  memset(&options, 0, sizeof(options));
+  options.flags = flags;
+  for (i = 0; i < LOADS; i++)
+    {
+      if (dwg_read_buffer_opts(data, size, &dwg, &options))
+        return -1;
+      dwg_free(&dwg);
+    }
+  return (now() - start) * 1e3 / LOADS;
+}
+
+int
+main(int argc, char *argv[])
+{
+  FILE *fp;
+  unsigned char *data;
+  long int size;
+  unsigned long int ref_sum, new_sum;
+  double ref, new, load, load_no_crc;
+  int error = 0;
+
+  if (argc < 2)
+    {
+      printf("Usage: %s <file> ...\n", argv[0]);
+      return 1;
+    }
+
+  printf("%-24s %10s %12s %12s %10s %10s\n", "file", "bytes",
+         "before MB/s", "after MB/s", "load ms", "no CRC ms");
+  for (; argc > 1; argc--, argv++)
+    {
+      fp = fopen(argv[1], "rb");
+      if (!fp)
+        {
+          perror(argv[1]);
+          return 1;
+        }
+      fseek(fp, 0, SEEK_END);
+      size = ftell(fp);
+      fseek(fp, 0, SEEK_SET);
+      data = (unsigned char *) malloc(size);
+      if (!data || fread(data, 1, size, fp) != (size_t) size)
+        {
+          perror(argv[1]);
+          return 1;
+        }
+      fclose(fp);
+
+      ref = measure(ref_ckr8, data, size, &ref_sum);
+      new = measure(bit_ckr8, data, size, &new_sum);
+      load = measure_load(data, size, 0);
+      load_no_crc = measure_load(data, size, DWG_OPT_NO_CRC);
+      printf("%-24s %10ld %12.1f %12.1f %10.3f %10.3f\n", argv[1], size,
+             ref, new, load, load_no_crc);
+      bench_record(argv[0], argv[1], "ckr8_before", ref, "MB/s");
+      bench_record(argv[0], argv[1], "ckr8", new, "MB/s");
+      bench_record(argv[0], argv[1], "load", load, "ms");
+      bench_record(argv[0], argv[1], "load_no_crc", load_no_crc, "ms");
+      if (ref_sum != new_sum)
+        {
+          fprintf(stderr, "%s: CRCs differ\n", argv[1]);
+          error = 1;
+        }
+      if (load < 0 || load_no_crc < 0)
+        {
+          fprintf(stderr, "%s: cannot load\n", argv[1]);
+          error = 1;
+        }
+      free(data);
+    }
+  return error;
+}
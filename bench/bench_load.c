@@ -0,0 +1,200 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * bench_load.c: full-file load and save, and handle resolution
+ *
+ * Each file, read into memory first, is loaded with the default options,
+ * then every handle of the drawing is looked up by
+ * dwg_find_object_by_handle, in a shuffled order, and the drawing is
+ * encoded back into memory by dwg_encode_chains.  Each measure is
+ * repeated for at least MIN_TIME, so that the small drawings are timed
+ * over many loads and the large ones over one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "encode.h"
+#include "bench.h"
+
+/* Seconds per measure, at least */
+#define MIN_TIME 0.5
+
+/* Lookups per measure, at least */
+#define MIN_LOOKUPS (4 * 1024 * 1024)
+
+/* Load the drawing LOADS times, and return the time of one load in ms,
+ * or -1, leaving the drawing of the last load in dwg.
+ */
+static double
+measure_load(unsigned char *data, long int size, Dwg_Data *dwg)
+{
+  double start = now();
+  int loads = 0;
+
+  do
+    {
+      if (loads)
+        dwg_free(dwg);
+      if (dwg_read_buffer_opts(data, size, dwg, 0))
+        return -1;
+      loads++;
+    }
+  while (now() - start < MIN_TIME);
+  return (now() - start) * 1e3 / loads;
+}
+
+/* Look up all handles of dwg, and return the throughput in millions of
+ * lookups per second, or -1 if one is not found.
+ */
+static double
+measure_handles(Dwg_Data *dwg)
+{
+  long unsigned int *handles, total = 0, i, j, swap, state = 1;
+  long unsigned int num_handles = dwg->num_objects;
+  Dwg_Object *obj;
+  double speed, start;
+
+  if (!num_handles)
+    return 0;
+  handles = (long unsigned int *) malloc(num_handles
+                                         * sizeof(long unsigned int));
+  if (!handles)
+    return -1;
+  for (i = 0; i < num_handles; i++)
+    handles[i] = dwg->object[i].handle.value;
+  for (i = num_handles - 1; i > 0; i--)
+    {
+      state = state * 6364136223846793005UL + 1442695040888963407UL;
+      j = (state >> 33) % (i + 1);
+      swap = handles[i];
+      handles[i] = handles[j];
+      handles[j] = swap;
+    }
+
+  start = now();
+  while (total < MIN_LOOKUPS)
+    {
+      for (i = 0; i < num_handles; i++)
+        {
+          obj = dwg_find_object_by_handle(dwg, handles[i]);
+          if (!obj || obj->handle.value != handles[i])
+            {
+              free(handles);
+              return -1;
+            }
+        }
+      total += num_handles;
+    }
+  speed = total / (now() - start) / 1e6;
+  free(handles);
+  return speed;
+}
+
+/* Encode dwg into memory, as measure_load, returning the size of the
+ * encoded file in encoded_size.
+ */
+static double
+measure_save(Dwg_Data *dwg, long unsigned int *encoded_size)
+{
+  Bit_Chain dat;
+  double start = now();
+  int saves = 0;
+
+  do
+    {
+      memset(&dat, 0, sizeof(dat));
+      dat.version = (Dwg_Version_Type) dwg->header.version;
+      if (dwg_encode_chains(dwg, &dat))
+        {
+          free(dat.chain);
+          return -1;
+        }
+      *encoded_size = dat.size;
+      free(dat.chain);
+      saves++;
+    }
+  while (now() - start < MIN_TIME);
+  return (now() - start) * 1e3 / saves;
+}
+
+int
+main(int argc, char *argv[])
+{
+  FILE *fp;
+  unsigned char *data;
+  long int size;
+  long unsigned int encoded_size = 0;
+  Dwg_Data dwg;
+  double load, handles, save;
+  int error = 0;
+
+  if (argc < 2)
+    {
+      printf("Usage: %s <file> ...\n", argv[0]);
+      return 1;
+    }
+
+  printf("%-24s %10s %10s %10s %14s %10s\n", "file", "bytes", "objects",
+         "load ms", "Mlookups/s", "save ms");
+  for (; argc > 1; argc--, argv++)
+    {
+      fp = fopen(argv[1], "rb");
+      if (!fp)
+        {
+          perror(argv[1]);
+          return 1;
+        }
+      fseek(fp, 0, SEEK_END);
+      size = ftell(fp);
+      fseek(fp, 0, SEEK_SET);
+      data = (unsigned char *) malloc(size);
+      if (!data || fread(data, 1, size, fp) != (size_t) size)
+        {
+          perror(argv[1]);
+          return 1;
+        }
+      fclose(fp);
+
+      load = measure_load(data, size, &dwg);
+      if (load < 0)
+        {
+          fprintf(stderr, "%s: cannot load\n", argv[1]);
+          error = 1;
+          free(data);
+          continue;
+        }
+      handles = measure_handles(&dwg);
+      save = measure_save(&dwg, &encoded_size);
+      printf("%-24s %10ld %10lu %10.3f %14.2f %10.3f\n", argv[1], size,
+             (long unsigned int) dwg.num_objects, load, handles, save);
+      bench_record(argv[0], argv[1], "load", load, "ms");
+      bench_record(argv[0], argv[1], "handle_lookups", handles, "M/s");
+      bench_record(argv[0], argv[1], "save", save, "ms");
+      bench_record(argv[0], argv[1], "save_bytes", encoded_size, "bytes");
+      if (handles < 0)
+        {
+          fprintf(stderr, "%s: handle not found\n", argv[1]);
+          error = 1;
+        }
+      if (save < 0)
+        {
+          fprintf(stderr, "%s: cannot encode\n", argv[1]);
+          error = 1;
+        }
+      dwg_free(&dwg);
+      free(data);
+    }
+  return error;
+}
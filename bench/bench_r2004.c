@@ -0,0 +1,466 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * bench_r2004.c: throughput of the R2004 section decompressor
+ *
+ * The sample drawings are R2000 files, with nothing compressed in
+ * them, so each file is cut into pages of the size of the R2004 object
+ * pages and compressed here, with a plain greedy LZ77 writing the R2004
+ * format.  The pages are then decompressed by decompress_R2004_section,
+ * and by the byte at a time decompressor it replaced, kept below for
+ * reference, and both results are checked against the file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bits.h"
+#include "decode_r2004.h"
+#include "bench.h"
+
+/* Decompressed size of the pages of the R2004 object section */
+#define PAGE_SIZE 0x7400
+
+/* Passes over the data per measure */
+#define MIN_BYTES (64 * 1024 * 1024)
+
+#define HASH_BITS 14
+
+typedef struct _page
+{
+  unsigned char *data;
+  unsigned long int size;
+  unsigned char *comp;
+  unsigned long int comp_size;
+} Page;
+
+/* Compressor
+ */
+
+/* Write a long length: a 0 for every 0xFF of length - 1, then the rest.
+ */
+static unsigned char *
+put_long_length(unsigned char *out, unsigned long int length)
+{
+  for (; length > 0xFF; length -= 0xFF)
+    *out++ = 0;
+  *out++ = length;
+  return out;
+}
+
+/* Write a long compression offset, which is not 0.  */
+static unsigned char *
+put_long_offset(unsigned char *out, unsigned long int value)
+{
+  if (value <= 0xFF)
+    *out++ = value;
+  else
+    {
+      *out++ = 0;
+      out = put_long_length(out, value - 0xFF);
+    }
+  return out;
+}
+
+/* Write the length of a run of more than 3 literals.  */
+static unsigned char *
+put_literal_length(unsigned char *out, unsigned long int length)
+{
+  if (length <= 0x12)
+    *out++ = length - 3;
+  else
+    {
+      *out++ = 0;
+      out = put_long_length(out, length - 0x12);
+    }
+  return out;
+}
+
+/* Write a match of length bytes from distance bytes back, followed by
+ * a run of lit_length literals (their length only).
+ */
+static unsigned char *
+put_match(unsigned char *out, unsigned long int distance,
+          unsigned long int length, unsigned long int lit_length)
+{
+  unsigned long int offset = distance - 1;
+  unsigned char low = lit_length <= 3 ? lit_length : 0;
+
+  if (offset <= 0x3FF && length <= 14)
+    {
+      *out++ = ((length + 1) << 4) | ((offset & 3) << 2) | low;
+      *out++ = offset >> 2;
+    }
+  else
+    {
+      if (offset <= 0x3FFF)
+        {
+          if (length <= 0x21)
+            *out++ = length + 0x1E;
+          else
+            {
+              *out++ = 0x20;
+              out = put_long_offset(out, length - 0x21);
+            }
+        }
+      else
+        {
+          offset -= 0x3FFF;
+          if (length <= 17)
+            *out++ = 0x10 | (length - 2);
+          else
+            {
+              *out++ = 0x10;
+              out = put_long_offset(out, length - 9);
+            }
+        }
+      *out++ = ((offset & 0x3F) << 2) | low;
+      *out++ = offset >> 6;
+    }
+  if (lit_length > 3)
+    out = put_literal_length(out, lit_length);
+  return out;
+}
+
+static unsigned long int
+hash(const unsigned char *p)
+{
+  return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - HASH_BITS)
+    & ((1 << HASH_BITS) - 1);
+}
+
+/* Compress a page, returning the size of the compressed data in out,
+ * which must hold twice the page.
+ */
+static unsigned long int
+compress_page(const unsigned char *in, unsigned long int size,
+              unsigned char *out)
+{
+  long int last[1 << HASH_BITS];
+  unsigned char *start = out;
+  unsigned long int pos, lit_start, length = 0, distance = 0;
+  unsigned long int match_length, match_distance;
+  int have_match = 0;
+  long int candidate;
+
+  memset(last, 0xFF, sizeof(last));
+  /* The first run of literals is at least 4 bytes long.  */
+  pos = size < 4 ? size : 4;
+  lit_start = 0;
+  while (pos < size)
+    {
+      match_length = 0;
+      if (pos + 3 <= size)
+        {
+          candidate = last[hash(in + pos)];
+          last[hash(in + pos)] = pos;
+          if (candidate >= 0 && pos - candidate <= 0x7FFE)
+            {
+              match_distance = pos - candidate;
+              while (pos + match_length < size
+                     && in[candidate + match_length] == in[pos + match_length])
+                match_length++;
+              if (match_length < 3 || (match_length < 4
+                                       && match_distance > 0x3FFF + 1))
+                match_length = 0;
+            }
+        }
+      if (!match_length)
+        {
+          pos++;
+          continue;
+        }
+      /* The literals before this match follow the previous one.  */
+      if (!have_match)
+        out = put_literal_length(out, pos - lit_start);
+      else
+        out = put_match(out, distance, length, pos - lit_start);
+      memcpy(out, in + lit_start, pos - lit_start);
+      out += pos - lit_start;
+      have_match = 1;
+      length = match_length;
+      distance = match_distance;
+      pos += match_length;
+      lit_start = pos;
+    }
+  if (!have_match)
+    out = put_literal_length(out, pos - lit_start);
+  else
+    out = put_match(out, distance, length, pos - lit_start);
+  memcpy(out, in + lit_start, pos - lit_start);
+  out += pos - lit_start;
+  *out++ = 0x11;
+  *out++ = 0;
+  *out++ = 0;
+  return out - start;
+}
+
+/* Reference decompressor, reading every byte through bit_read_RC
+ */
+
+static int
+ref_literal_length(Bit_Chain* dat, unsigned char *opcode)
+{
+  int total = 0;
+  unsigned char byte = bit_read_RC(dat);
+
+  *opcode = 0x00;
+
+  if (byte >= 0x01 && byte <= 0x0F)
+    return byte + 3;
+  else if (byte == 0)
+    {
+      total = 0x0F;
+      while ((byte = bit_read_RC(dat)) == 0x00)
+        {
+          total += 0xFF;
+        }
+      return total + byte + 3;
+    }
+  else if (byte & 0xF0)
+    *opcode = byte;
+
+  return 0;
+}
+
+static int
+ref_long_compression_offset(Bit_Chain* dat)
+{
+  int total = 0;
+  unsigned char byte = bit_read_RC(dat);
+  if (byte == 0)
+    {
+      total = 0xFF;
+      while ((byte = bit_read_RC(dat)) == 0x00)
+        total += 0xFF;
+    }
+  return total + byte;
+}
+
+static int
+ref_two_byte_offset(Bit_Chain* dat, int* lit_length)
+{
+  int offset;
+  unsigned char firstByte = bit_read_RC(dat);
+  unsigned char secondByte = bit_read_RC(dat);
+  offset = (firstByte >> 2) | (secondByte << 6);
+  *lit_length = (firstByte & 0x03);
+  return offset;
+}
+
+static int
+ref_decompress(Bit_Chain* dat, char *decomp, unsigned long int comp_data_size)
+{
+  int lit_length, i;
+  int comp_offset, comp_bytes;
+  unsigned char opcode1 = 0, opcode2;
+  long int start_byte = dat->byte;
+  char *src, *dst = decomp;
+
+  lit_length = ref_literal_length(dat, &opcode1);
+
+  for (i = 0; i < lit_length; ++i)
+    *dst++ = bit_read_RC(dat);
+
+  opcode1 = 0x00;
+  while (dat->byte - start_byte < comp_data_size)
+    {
+      if (opcode1 == 0x00)
+        opcode1 = bit_read_RC(dat);
+
+      if (opcode1 >= 0x40)
+        {
+          comp_bytes = ((opcode1 & 0xF0) >> 4) - 1;
+          opcode2 = bit_read_RC(dat);
+          comp_offset = (opcode2 << 2) | ((opcode1 & 0x0C) >> 2);
+
+          if (opcode1 & 0x03)
+            {
+              lit_length = (opcode1 & 0x03);
+              opcode1  = 0x00;
+            }
+          else
+            lit_length = ref_literal_length(dat, &opcode1);
+        }
+      else if (opcode1 >= 0x21 && opcode1 <= 0x3F)
+        {
+          comp_bytes  = opcode1 - 0x1E;
+          comp_offset = ref_two_byte_offset(dat, &lit_length);
+
+          if (lit_length != 0)
+            opcode1 = 0x00;
+          else
+            lit_length = ref_literal_length(dat, &opcode1);
+        }
+      else if (opcode1 == 0x20)
+        {
+          comp_bytes  = ref_long_compression_offset(dat) + 0x21;
+          comp_offset = ref_two_byte_offset(dat, &lit_length);
+
+          if (lit_length != 0)
+            opcode1 = 0x00;
+          else
+            lit_length = ref_literal_length(dat, &opcode1);
+        }
+      else if (opcode1 >= 0x12 && opcode1 <= 0x1F)
+        {
+          comp_bytes  = (opcode1 & 0x0F) + 2;
+          comp_offset = ref_two_byte_offset(dat, &lit_length) + 0x3FFF;
+
+          if (lit_length != 0)
+            opcode1 = 0x00;
+          else
+            lit_length = ref_literal_length(dat, &opcode1);
+        }
+      else if (opcode1 == 0x10)
+        {
+          comp_bytes  = ref_long_compression_offset(dat) + 9;
+          comp_offset = ref_two_byte_offset(dat, &lit_length) + 0x3FFF;
+
+          if (lit_length != 0)
+            opcode1 = 0x00;
+          else
+            lit_length = ref_literal_length(dat, &opcode1);
+        }
+      else if (opcode1 == 0x11)
+          break;
+      else
+          return 1;
+
+      src = dst - comp_offset - 1;
+      for (i = 0; i < comp_bytes; ++i)
+        *dst++ = *src++;
+
+      for (i = 0; i < lit_length; ++i)
+        *dst++ = bit_read_RC(dat);
+    }
+
+  return 0;
+}
+
+/* Benchmark
+ */
+
+typedef int (*Decompressor) (Bit_Chain *dat, char *decomp, Page *page);
+
+static int
+run_ref(Bit_Chain *dat, char *decomp, Page *page)
+{
+  return ref_decompress(dat, decomp, page->comp_size);
+}
+
+static int
+run_new(Bit_Chain *dat, char *decomp, Page *page)
+{
+  return decompress_R2004_section(dat, decomp, PAGE_SIZE, page->comp_size);
+}
+
+/* Decompress all pages, checking them, until MIN_BYTES are out, and
+ * return the throughput in MB/s of decompressed data, or -1.
+ */
+static double
+measure(Decompressor decompress, Page *pages, int num_pages)
+{
+  static char decomp[PAGE_SIZE];
+  unsigned long int total = 0;
+  Bit_Chain dat;
+  double start = now();
+  int i;
+
+  memset(&dat, 0, sizeof(dat));
+  while (total < MIN_BYTES)
+    for (i = 0; i < num_pages; i++)
+      {
+        dat.chain = pages[i].comp;
+        dat.size = pages[i].comp_size;
+        dat.byte = 0;
+        dat.bit = 0;
+        if (decompress(&dat, decomp, &pages[i])
+            || memcmp(decomp, pages[i].data, pages[i].size))
+          return -1;
+        total += pages[i].size;
+      }
+  return total / (now() - start) / 1e6;
+}
+
+int
+main(int argc, char *argv[])
+{
+  FILE *fp;
+  unsigned char *data;
+  long int size;
+  Page *pages;
+  int i, num_pages, error = 0;
+  unsigned long int comp_size;
+  double ref, new;
+
+  if (argc < 2)
+    {
+      printf("Usage: %s <file> ...\n", argv[0]);
+      return 1;
+    }
+
+  printf("%-24s %10s %10s %12s %12s\n", "file", "bytes", "compressed",
+         "before MB/s", "after MB/s");
+  for (; argc > 1; argc--, argv++)
+    {
+      fp = fopen(argv[1], "rb");
+      if (!fp)
+        {
+          perror(argv[1]);
+          return 1;
+        }
+      fseek(fp, 0, SEEK_END);
+      size = ftell(fp);
+      fseek(fp, 0, SEEK_SET);
+      data = (unsigned char *) malloc(size);
+      if (!data || fread(data, 1, size, fp) != (size_t) size)
+        {
+          perror(argv[1]);
+          return 1;
+        }
+      fclose(fp);
+
+      num_pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+      pages = (Page *) calloc(num_pages, sizeof(Page));
+      comp_size = 0;
+      for (i = 0; i < num_pages; i++)
+        {
+          pages[i].data = data + i * PAGE_SIZE;
+          pages[i].size = i + 1 < num_pages ? PAGE_SIZE : size - i * PAGE_SIZE;
+          pages[i].comp = (unsigned char *) malloc(2 * PAGE_SIZE + 16);
+          pages[i].comp_size = compress_page(pages[i].data, pages[i].size,
+                                             pages[i].comp);
+          comp_size += pages[i].comp_size;
+        }
+
+      ref = measure(run_ref, pages, num_pages);
+      new = measure(run_new, pages, num_pages);
+      printf("%-24s %10ld %10lu %12.1f %12.1f\n", argv[1], size, comp_size,
+             ref, new);
+      bench_record(argv[0], argv[1], "decompress_before", ref, "MB/s");
+      bench_record(argv[0], argv[1], "decompress", new, "MB/s");
+      if (ref < 0 || new < 0)
+        {
+          fprintf(stderr, "%s: decompressed data differs\n", argv[1]);
+          error = 1;
+        }
+
+      for (i = 0; i < num_pages; i++)
+        free(pages[i].comp);
+      free(pages);
+      free(data);
+    }
+  return error;
+}
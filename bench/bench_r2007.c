@@ -0,0 +1,352 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * bench_r2007.c: throughput of the R2007 data page reader
+ *
+ * As for bench_r2004, the sample drawings are cut into pages, which are
+ * compressed in the R2007 format and interleaved into Reed-Solomon
+ * codewords (with blank parity bytes) here.  read_data_page then reads
+ * them back, once as stored pages, which measures the de-interleaving
+ * alone, and once compressed.  The results are checked against the
+ * file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "decode_r2007.h"
+#include "bench.h"
+
+/* Decompressed size of the pages of the R2007 data sections */
+#define PAGE_SIZE 0x7400
+
+/* Data bytes per codeword of a data page */
+#define RS_DATA 0xFB
+#define RS_CODEWORD 0xFF
+
+/* Passes over the data per measure */
+#define MIN_BYTES (64 * 1024 * 1024)
+
+#define HASH_BITS 14
+
+typedef struct _page
+{
+  unsigned char *data;
+  unsigned long int size;
+  char *rsdata;
+  unsigned long int comp_size;
+  unsigned long int page_size;
+} Page;
+
+/* Order in which a literal run of n bytes is stored, for n up to 32:
+ * byte i of the run is stored at literal_order[n][i].  */
+static unsigned char literal_order[33][32];
+
+/* Compressor
+ */
+
+/* Write the length of a run of 8 or more literals, as an opcode.  */
+static unsigned char *
+put_literal_length(unsigned char *out, unsigned long int length)
+{
+  if (length < 0x17)
+    *out++ = length - 8;
+  else if (length - 0x17 < 0xFF)
+    {
+      *out++ = 0x0F;
+      *out++ = length - 0x17;
+    }
+  else
+    {
+      *out++ = 0x0F;
+      *out++ = 0xFF;
+      for (length -= 0x17 + 0xFF; length >= 0xFFFF; length -= 0xFFFF)
+        {
+          *out++ = 0xFF;
+          *out++ = 0xFF;
+        }
+      *out++ = length & 0xFF;
+      *out++ = length >> 8;
+    }
+  return out;
+}
+
+/* Write a run of literals, in their stored order.  */
+static unsigned char *
+put_literals(unsigned char *out, const unsigned char *in,
+             unsigned long int length)
+{
+  unsigned long int i;
+  unsigned int n;
+
+  for (; length; in += n, out += n, length -= n)
+    {
+      n = length >= 32 ? 32 : length;
+      for (i = 0; i < n; i++)
+        out[literal_order[n][i]] = in[i];
+    }
+  return out;
+}
+
+/* Write the first run of literals of a page.  */
+static unsigned char *
+put_first_literals(unsigned char *out, const unsigned char *in,
+                   unsigned long int length)
+{
+  if (length < 8)
+    {
+      *out++ = 0x20;
+      *out++ = 0;
+      *out++ = 0;
+      *out++ = length;
+    }
+  else
+    out = put_literal_length(out, length);
+  return put_literals(out, in, length);
+}
+
+/* Write a match of 3 to 18 bytes from distance bytes back, up to 8192,
+ * and the run of literals that follows.  */
+static unsigned char *
+put_match(unsigned char *out, unsigned long int distance,
+          unsigned long int length, const unsigned char *in,
+          unsigned long int lit_length)
+{
+  *out++ = 0x10 | (length - 3);
+  *out++ = (distance - 1) & 0xFF;
+  *out++ = ((distance - 1) >> 8) << 3 | (lit_length < 8 ? lit_length : 0);
+  if (lit_length >= 8)
+    out = put_literal_length(out, lit_length);
+  return put_literals(out, in, lit_length);
+}
+
+static unsigned long int
+hash(const unsigned char *p)
+{
+  return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - HASH_BITS)
+    & ((1 << HASH_BITS) - 1);
+}
+
+/* Compress a page, returning the size of the compressed data in out,
+ * which must hold twice the page.
+ */
+static unsigned long int
+compress_page(const unsigned char *in, unsigned long int size,
+              unsigned char *out)
+{
+  long int last[1 << HASH_BITS];
+  unsigned char *start = out;
+  unsigned long int pos = 1, lit_start = 0, length = 0, distance = 0;
+  unsigned long int match_length;
+  long int candidate;
+
+  memset(last, 0xFF, sizeof(last));
+  while (pos < size)
+    {
+      match_length = 0;
+      if (pos + 3 <= size)
+        {
+          candidate = last[hash(in + pos)];
+          last[hash(in + pos)] = pos;
+          if (candidate >= 0 && pos - candidate <= 8192)
+            while (pos + match_length < size && match_length < 18
+                   && in[candidate + match_length] == in[pos + match_length])
+              match_length++;
+        }
+      if (match_length < 3)
+        {
+          pos++;
+          continue;
+        }
+      if (!length)
+        out = put_first_literals(out, in + lit_start, pos - lit_start);
+      else
+        out = put_match(out, distance, length, in + lit_start,
+                        pos - lit_start);
+      length = match_length;
+      distance = pos - candidate;
+      pos += match_length;
+      lit_start = pos;
+    }
+  if (!length)
+    out = put_first_literals(out, in, size);
+  else
+    out = put_match(out, distance, length, in + lit_start, size - lit_start);
+  return out - start;
+}
+
+/* Find the stored order of literal runs, by decompressing runs of the
+ * numbers 0 to n - 1.
+ */
+static void
+init_literal_order(void)
+{
+  unsigned char in[32], stream[40], out[32];
+  unsigned int n, i;
+
+  for (i = 0; i < 32; i++)
+    in[i] = i;
+  for (n = 1; n <= 32; n++)
+    {
+      unsigned char *end;
+
+      /* Stored in order first, the numbers come out in stored order.  */
+      for (i = 0; i < n; i++)
+        literal_order[n][i] = i;
+      end = put_first_literals(stream, in, n);
+      decompress_r2007((char *) out, n, (char *) stream, end - stream);
+      for (i = 0; i < n; i++)
+        literal_order[n][i] = out[i];
+    }
+}
+
+/* Interleave data, of comp_size bytes, into the Reed-Solomon codewords
+ * of a page, returning its size.
+ */
+static unsigned long int
+interleave_page(const unsigned char *data, unsigned long int comp_size,
+                char *rsdata)
+{
+  unsigned long int block_count = (((comp_size + 7) & ~7) + RS_DATA - 1)
+    / RS_DATA;
+  unsigned long int page_size = (block_count * RS_CODEWORD + 7) & ~7;
+  unsigned long int i, j;
+
+  memset(rsdata, 0, page_size);
+  for (i = 0; i < block_count; i++)
+    for (j = 0; j < RS_DATA && i * RS_DATA + j < comp_size; j++)
+      rsdata[j * block_count + i] = data[i * RS_DATA + j];
+  return page_size;
+}
+
+/* Benchmark
+ */
+
+/* Read all pages, checking them, until MIN_BYTES are out, and return
+ * the throughput in MB/s of decompressed data, or -1.
+ */
+static double
+measure(Page *pages, int num_pages)
+{
+  static unsigned char decomp[PAGE_SIZE];
+  static char pedata[2 * PAGE_SIZE + 1024];
+  unsigned long int total = 0;
+  Bit_Chain dat;
+  double start = now();
+  int i;
+
+  while (total < MIN_BYTES)
+    for (i = 0; i < num_pages; i++)
+      {
+        dat.chain = (unsigned char *) pages[i].rsdata;
+        dat.size = pages[i].page_size;
+        dat.byte = 0;
+        dat.bit = 0;
+        if (read_data_page(&dat, decomp, pages[i].page_size,
+                           pages[i].comp_size, pages[i].size, pedata)
+            || memcmp(decomp, pages[i].data, pages[i].size))
+          return -1;
+        total += pages[i].size;
+      }
+  return total / (now() - start) / 1e6;
+}
+
+/* Make the pages of data, compressed or not, and measure them.  */
+static double
+measure_pages(unsigned char *data, long int size, int compress,
+              unsigned long int *comp_size)
+{
+  int num_pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+  Page *pages = (Page *) calloc(num_pages, sizeof(Page));
+  unsigned char *comp = (unsigned char *) malloc(2 * PAGE_SIZE);
+  double speed;
+  int i;
+
+  *comp_size = 0;
+  for (i = 0; i < num_pages; i++)
+    {
+      pages[i].data = data + i * PAGE_SIZE;
+      pages[i].size = i + 1 < num_pages ? PAGE_SIZE : size - i * PAGE_SIZE;
+      pages[i].comp_size = pages[i].size;
+      if (compress)
+        pages[i].comp_size = compress_page(pages[i].data, pages[i].size, comp);
+      if (pages[i].comp_size >= pages[i].size)
+        pages[i].comp_size = pages[i].size;
+      pages[i].rsdata = (char *) malloc(2 * PAGE_SIZE + 1024);
+      pages[i].page_size = interleave_page(
+          pages[i].comp_size < pages[i].size ? comp : pages[i].data,
+          pages[i].comp_size, pages[i].rsdata);
+      *comp_size += pages[i].comp_size;
+    }
+  speed = measure(pages, num_pages);
+  for (i = 0; i < num_pages; i++)
+    free(pages[i].rsdata);
+  free(pages);
+  free(comp);
+  return speed;
+}
+
+int
+main(int argc, char *argv[])
+{
+  FILE *fp;
+  unsigned char *data;
+  long int size;
+  unsigned long int comp_size;
+  double stored, compressed;
+  int error = 0;
+
+  if (argc < 2)
+    {
+      printf("Usage: %s <file> ...\n", argv[0]);
+      return 1;
+    }
+
+  init_literal_order();
+  printf("%-24s %10s %10s %12s %12s\n", "file", "bytes", "compressed",
+         "stored MB/s", "comp. MB/s");
+  for (; argc > 1; argc--, argv++)
+    {
+      fp = fopen(argv[1], "rb");
+      if (!fp)
+        {
+          perror(argv[1]);
+          return 1;
+        }
+      fseek(fp, 0, SEEK_END);
+      size = ftell(fp);
+      fseek(fp, 0, SEEK_SET);
+      data = (unsigned char *) malloc(size);
+      if (!data || fread(data, 1, size, fp) != (size_t) size)
+        {
+          perror(argv[1]);
+          return 1;
+        }
+      fclose(fp);
+
+      stored = measure_pages(data, size, 0, &comp_size);
+      compressed = measure_pages(data, size, 1, &comp_size);
+      printf("%-24s %10ld %10lu %12.1f %12.1f\n", argv[1], size, comp_size,
+             stored, compressed);
+      bench_record(argv[0], argv[1], "decompress_stored", stored, "MB/s");
+      bench_record(argv[0], argv[1], "decompress", compressed, "MB/s");
+      if (stored < 0 || compressed < 0)
+        {
+          fprintf(stderr, "%s: read data differs\n", argv[1]);
+          error = 1;
+        }
+      free(data);
+    }
+  return error;
+}
@@ -0,0 +1,203 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * gen_dwg.c: write a large synthetic R2000 drawing
+ *
+ * Usage: gen_dwg [-n entities] template.dwg output.dwg
+ *
+ * The template, an R2000 drawing, is loaded with DWG_OPT_LAZY, so that
+ * its own objects are copied as they are by the encoder, and the given
+ * number of LINE entities (10000 by default) is added to it, on the
+ * current layer, with handles following the largest one of the template
+ * and pseudo-random coordinates, always the same.  The lines are not
+ * linked from the model space block header: they are read back as
+ * entities of the drawing, but not drawn by applications following the
+ * blocks.
+ *
+ * The lines share POOL_SIZE entity structures, the encoder reading but
+ * the coordinates of them, so that ten million of them fit in memory.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <dwg.h>
+#include "common.h"
+
+/* Distinct lines */
+#define POOL_SIZE 4096
+
+/* Size of a line, in bytes, as reserved by the encoder */
+#define LINE_SIZE 48
+
+static double
+random_coordinate(long unsigned int *state)
+{
+  *state = *state * 6364136223846793005UL + 1442695040888963407UL;
+  return ((*state >> 11) * (1.0 / (1UL << 53)) - 0.5) * 2000.0;
+}
+
+/* Fill the pool of lines, on the layer.
+ */
+static void
+init_lines(Dwg_Object_Entity *entities, Dwg_Entity_LINE *lines,
+           Dwg_Object_Ref *xdic, Dwg_Object_Ref *layer)
+{
+  long unsigned int state = 1;
+  int i;
+
+  for (i = 0; i < POOL_SIZE; i++)
+    {
+      entities[i].tio.LINE = &lines[i];
+      entities[i].entity_mode = 2;
+      entities[i].nolinks = 1;
+      entities[i].color.index = 256;
+      entities[i].linetype_scale = 1.0;
+      entities[i].lineweight = 29;
+      entities[i].xdicobjhandle = xdic;
+      entities[i].layer = layer;
+
+      lines[i].start.x = random_coordinate(&state);
+      lines[i].start.y = random_coordinate(&state);
+      lines[i].end.x = random_coordinate(&state);
+      lines[i].end.y = random_coordinate(&state);
+      lines[i].extrusion.z = 1.0;
+    }
+}
+
+/* Add num_lines lines to dwg, from the pool of entities.  Returns -1 if
+ * out of memory.
+ */
+static int
+add_lines(Dwg_Data *dwg, Dwg_Object_Entity *entities,
+          long unsigned int num_lines)
+{
+  long unsigned int i, handle = 0;
+  Dwg_Object *objects, *obj;
+
+  for (i = 0; i < dwg->num_objects; i++)
+    if (dwg->object[i].handle.value > handle)
+      handle = dwg->object[i].handle.value;
+
+  objects = (Dwg_Object *) realloc(dwg->object, (dwg->num_objects + num_lines)
+                                   * sizeof(Dwg_Object));
+  if (!objects)
+    return -1;
+  dwg->object = objects;
+  dwg->num_alloced_objects = dwg->num_objects + num_lines;
+
+  for (i = 0; i < num_lines; i++)
+    {
+      obj = &dwg->object[dwg->num_objects + i];
+      memset(obj, 0, sizeof(Dwg_Object));
+      obj->size = LINE_SIZE;
+      obj->type = DWG_TYPE_LINE;
+      obj->index = dwg->num_objects + i;
+      obj->supertype = DWG_SUPERTYPE_ENTITY;
+      obj->tio.entity = &entities[i % POOL_SIZE];
+      obj->handle.code = 0;
+      obj->handle.value = ++handle;
+      obj->handle.size = handle > 0xFFFFFF ? 4 : handle > 0xFFFF ? 3
+        : handle > 0xFF ? 2 : 1;
+      obj->parent = dwg;
+    }
+  dwg->num_objects += num_lines;
+  dwg->num_entities += num_lines;
+  dwg->header_vars.HANDSEED->handleref.value = handle + 1;
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  Dwg_Read_Options options;
+  Dwg_Data dwg;
+  Dwg_Object_Entity *entities;
+  Dwg_Entity_LINE *lines;
+  Dwg_Object_Ref xdic, layer;
+  long unsigned int num_lines = 10000, num_objects, num_entities;
+  int opt, error;
+
+  while ((opt = getopt(argc, argv, "n:")) != -1)
+    switch (opt)
+      {
+      case 'n':
+        num_lines = strtoul(optarg, 0, 10);
+        break;
+      default:
+        printf("Usage: %s [-n entities] template.dwg output.dwg\n", argv[0]);
+        return 1;
+      }
+  if (argc - optind != 2)
+    {
+      printf("Usage: %s [-n entities] template.dwg output.dwg\n", argv[0]);
+      return 1;
+    }
+
+  memset(&options, 0, sizeof(options));
+  options.flags = DWG_OPT_LAZY;
+  if (dwg_read_file_opts(argv[optind], &dwg, &options))
+    {
+      fprintf(stderr, "%s: cannot load\n", argv[optind]);
+      return 1;
+    }
+  if (dwg.header.version != R_2000 || !dwg.header_vars.HANDSEED
+      || !dwg.header_vars.CLAYER)
+    {
+      fprintf(stderr, "%s: not an R2000 drawing\n", argv[optind]);
+      dwg_free(&dwg);
+      return 1;
+    }
+
+  memset(&xdic, 0, sizeof(xdic));
+  xdic.handleref.code = 3;
+  memset(&layer, 0, sizeof(layer));
+  layer.handleref.code = 5;
+  layer.handleref.value = dwg.header_vars.CLAYER->absolute_ref;
+  if (!layer.handleref.value)
+    layer.handleref.value = dwg.header_vars.CLAYER->handleref.value;
+
+  entities = (Dwg_Object_Entity *) calloc(POOL_SIZE,
+                                          sizeof(Dwg_Object_Entity));
+  lines = (Dwg_Entity_LINE *) calloc(POOL_SIZE, sizeof(Dwg_Entity_LINE));
+  num_objects = dwg.num_objects;
+  num_entities = dwg.num_entities;
+  error = !entities || !lines || add_lines(&dwg, entities, num_lines);
+  if (error)
+    fprintf(stderr, "Out of memory\n");
+  else
+    {
+      init_lines(entities, lines, &xdic, &layer);
+#ifdef USE_WRITE
+      unlink(argv[optind + 1]);
+      error = dwg_write_file(argv[optind + 1], &dwg);
+      if (error)
+        fprintf(stderr, "%s: cannot write\n", argv[optind + 1]);
+#else
+      fprintf(stderr, "%s: built without write support (--enable-write)\n",
+              argv[0]);
+      error = 1;
+#endif
+    }
+
+  /* The lines are not the drawing's to free.  */
+  dwg.num_objects = num_objects;
+  dwg.num_entities = num_entities;
+  dwg_free(&dwg);
+  free(entities);
+  free(lines);
+  return error ? 1 : 0;
+}
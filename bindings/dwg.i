@@ -24,5 +24,6 @@
 
 %include "carrays.i"
 %array_functions(Dwg_Object, Dwg_Object_Array);
+%array_functions(long unsigned int, Dwg_Count_Array);
 
 #include "../../src/dwg.h"
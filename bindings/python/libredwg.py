@@ -83,6 +83,22 @@ Dwg_Object_Array_getitem = _libredwg.Dwg_Object_Array_getitem
 def Dwg_Object_Array_setitem(*args):
   return _libredwg.Dwg_Object_Array_setitem(*args)
 Dwg_Object_Array_setitem = _libredwg.Dwg_Object_Array_setitem
+
+def new_Dwg_Count_Array(*args):
+  return _libredwg.new_Dwg_Count_Array(*args)
+new_Dwg_Count_Array = _libredwg.new_Dwg_Count_Array
+
+def delete_Dwg_Count_Array(*args):
+  return _libredwg.delete_Dwg_Count_Array(*args)
+delete_Dwg_Count_Array = _libredwg.delete_Dwg_Count_Array
+
+def Dwg_Count_Array_getitem(*args):
+  return _libredwg.Dwg_Count_Array_getitem(*args)
+Dwg_Count_Array_getitem = _libredwg.Dwg_Count_Array_getitem
+
+def Dwg_Count_Array_setitem(*args):
+  return _libredwg.Dwg_Count_Array_setitem(*args)
+Dwg_Count_Array_setitem = _libredwg.Dwg_Count_Array_setitem
 FORMAT_RC = _libredwg.FORMAT_RC
 FORMAT_MC = _libredwg.FORMAT_MC
 FORMAT_MS = _libredwg.FORMAT_MS
@@ -191,6 +207,7 @@ Dwg_Bitcode_3BD_swigregister(Dwg_Bitcode_3BD)
 DWG_SUPERTYPE_UNKNOWN = _libredwg.DWG_SUPERTYPE_UNKNOWN
 DWG_SUPERTYPE_ENTITY = _libredwg.DWG_SUPERTYPE_ENTITY
 DWG_SUPERTYPE_OBJECT = _libredwg.DWG_SUPERTYPE_OBJECT
+DWG_SUPERTYPE_UNDECODED = _libredwg.DWG_SUPERTYPE_UNDECODED
 DWG_TYPE_UNUSED = _libredwg.DWG_TYPE_UNUSED
 DWG_TYPE_TEXT = _libredwg.DWG_TYPE_TEXT
 DWG_TYPE_ATTRIB = _libredwg.DWG_TYPE_ATTRIB
@@ -7387,6 +7404,9 @@ class Dwg_Object(_object):
     __swig_setmethods__["index"] = _libredwg.Dwg_Object_index_set
     __swig_getmethods__["index"] = _libredwg.Dwg_Object_index_get
     if _newclass:index = _swig_property(_libredwg.Dwg_Object_index_get, _libredwg.Dwg_Object_index_set)
+    __swig_setmethods__["address"] = _libredwg.Dwg_Object_address_set
+    __swig_getmethods__["address"] = _libredwg.Dwg_Object_address_get
+    if _newclass:address = _swig_property(_libredwg.Dwg_Object_address_get, _libredwg.Dwg_Object_address_set)
     __swig_setmethods__["supertype"] = _libredwg.Dwg_Object_supertype_set
     __swig_getmethods__["supertype"] = _libredwg.Dwg_Object_supertype_get
     if _newclass:supertype = _swig_property(_libredwg.Dwg_Object_supertype_get, _libredwg.Dwg_Object_supertype_set)
@@ -7458,6 +7478,12 @@ class Dwg_Class(_object):
     __swig_setmethods__["item_class_id"] = _libredwg.Dwg_Class_item_class_id_set
     __swig_getmethods__["item_class_id"] = _libredwg.Dwg_Class_item_class_id_get
     if _newclass:item_class_id = _swig_property(_libredwg.Dwg_Class_item_class_id_get, _libredwg.Dwg_Class_item_class_id_set)
+    __swig_setmethods__["decode"] = _libredwg.Dwg_Class_decode_set
+    __swig_getmethods__["decode"] = _libredwg.Dwg_Class_decode_get
+    if _newclass:decode = _swig_property(_libredwg.Dwg_Class_decode_get, _libredwg.Dwg_Class_decode_set)
+    __swig_setmethods__["skip"] = _libredwg.Dwg_Class_skip_set
+    __swig_getmethods__["skip"] = _libredwg.Dwg_Class_skip_get
+    if _newclass:skip = _swig_property(_libredwg.Dwg_Class_skip_get, _libredwg.Dwg_Class_skip_set)
     def __init__(self): 
         this = _libredwg.new_Dwg_Class()
         try: self.this.append(this)
@@ -7467,6 +7493,90 @@ class Dwg_Class(_object):
 Dwg_Class_swigregister = _libredwg.Dwg_Class_swigregister
 Dwg_Class_swigregister(Dwg_Class)
 
+class Dwg_Handle_Index(_object):
+    __swig_setmethods__ = {}
+    __setattr__ = lambda self, name, value: _swig_setattr(self, Dwg_Handle_Index, name, value)
+    __swig_getmethods__ = {}
+    __getattr__ = lambda self, name: _swig_getattr(self, Dwg_Handle_Index, name)
+    __repr__ = _swig_repr
+    __swig_setmethods__["handle"] = _libredwg.Dwg_Handle_Index_handle_set
+    __swig_getmethods__["handle"] = _libredwg.Dwg_Handle_Index_handle_get
+    if _newclass:handle = _swig_property(_libredwg.Dwg_Handle_Index_handle_get, _libredwg.Dwg_Handle_Index_handle_set)
+    __swig_setmethods__["index"] = _libredwg.Dwg_Handle_Index_index_set
+    __swig_getmethods__["index"] = _libredwg.Dwg_Handle_Index_index_get
+    if _newclass:index = _swig_property(_libredwg.Dwg_Handle_Index_index_get, _libredwg.Dwg_Handle_Index_index_set)
+    def __init__(self): 
+        this = _libredwg.new_Dwg_Handle_Index()
+        try: self.this.append(this)
+        except: self.this = this
+    __swig_destroy__ = _libredwg.delete_Dwg_Handle_Index
+    __del__ = lambda self : None;
+Dwg_Handle_Index_swigregister = _libredwg.Dwg_Handle_Index_swigregister
+Dwg_Handle_Index_swigregister(Dwg_Handle_Index)
+
+class Dwg_Load_Stats(_object):
+    __swig_setmethods__ = {}
+    __setattr__ = lambda self, name, value: _swig_setattr(self, Dwg_Load_Stats, name, value)
+    __swig_getmethods__ = {}
+    __getattr__ = lambda self, name: _swig_getattr(self, Dwg_Load_Stats, name)
+    __repr__ = _swig_repr
+    __swig_setmethods__["locate_time"] = _libredwg.Dwg_Load_Stats_locate_time_set
+    __swig_getmethods__["locate_time"] = _libredwg.Dwg_Load_Stats_locate_time_get
+    if _newclass:locate_time = _swig_property(_libredwg.Dwg_Load_Stats_locate_time_get, _libredwg.Dwg_Load_Stats_locate_time_set)
+    __swig_setmethods__["header_time"] = _libredwg.Dwg_Load_Stats_header_time_set
+    __swig_getmethods__["header_time"] = _libredwg.Dwg_Load_Stats_header_time_get
+    if _newclass:header_time = _swig_property(_libredwg.Dwg_Load_Stats_header_time_get, _libredwg.Dwg_Load_Stats_header_time_set)
+    __swig_setmethods__["classes_time"] = _libredwg.Dwg_Load_Stats_classes_time_set
+    __swig_getmethods__["classes_time"] = _libredwg.Dwg_Load_Stats_classes_time_get
+    if _newclass:classes_time = _swig_property(_libredwg.Dwg_Load_Stats_classes_time_get, _libredwg.Dwg_Load_Stats_classes_time_set)
+    __swig_setmethods__["object_map_time"] = _libredwg.Dwg_Load_Stats_object_map_time_set
+    __swig_getmethods__["object_map_time"] = _libredwg.Dwg_Load_Stats_object_map_time_get
+    if _newclass:object_map_time = _swig_property(_libredwg.Dwg_Load_Stats_object_map_time_get, _libredwg.Dwg_Load_Stats_object_map_time_set)
+    __swig_setmethods__["objects_time"] = _libredwg.Dwg_Load_Stats_objects_time_set
+    __swig_getmethods__["objects_time"] = _libredwg.Dwg_Load_Stats_objects_time_get
+    if _newclass:objects_time = _swig_property(_libredwg.Dwg_Load_Stats_objects_time_get, _libredwg.Dwg_Load_Stats_objects_time_set)
+    __swig_setmethods__["resolve_time"] = _libredwg.Dwg_Load_Stats_resolve_time_set
+    __swig_getmethods__["resolve_time"] = _libredwg.Dwg_Load_Stats_resolve_time_get
+    if _newclass:resolve_time = _swig_property(_libredwg.Dwg_Load_Stats_resolve_time_get, _libredwg.Dwg_Load_Stats_resolve_time_set)
+    __swig_setmethods__["total_time"] = _libredwg.Dwg_Load_Stats_total_time_set
+    __swig_getmethods__["total_time"] = _libredwg.Dwg_Load_Stats_total_time_get
+    if _newclass:total_time = _swig_property(_libredwg.Dwg_Load_Stats_total_time_get, _libredwg.Dwg_Load_Stats_total_time_set)
+    __swig_setmethods__["bytes_decompressed"] = _libredwg.Dwg_Load_Stats_bytes_decompressed_set
+    __swig_getmethods__["bytes_decompressed"] = _libredwg.Dwg_Load_Stats_bytes_decompressed_get
+    if _newclass:bytes_decompressed = _swig_property(_libredwg.Dwg_Load_Stats_bytes_decompressed_get, _libredwg.Dwg_Load_Stats_bytes_decompressed_set)
+    __swig_setmethods__["objects_by_type"] = _libredwg.Dwg_Load_Stats_objects_by_type_set
+    __swig_getmethods__["objects_by_type"] = _libredwg.Dwg_Load_Stats_objects_by_type_get
+    if _newclass:objects_by_type = _swig_property(_libredwg.Dwg_Load_Stats_objects_by_type_get, _libredwg.Dwg_Load_Stats_objects_by_type_set)
+    __swig_setmethods__["class_objects"] = _libredwg.Dwg_Load_Stats_class_objects_set
+    __swig_getmethods__["class_objects"] = _libredwg.Dwg_Load_Stats_class_objects_get
+    if _newclass:class_objects = _swig_property(_libredwg.Dwg_Load_Stats_class_objects_get, _libredwg.Dwg_Load_Stats_class_objects_set)
+    __swig_setmethods__["allocs"] = _libredwg.Dwg_Load_Stats_allocs_set
+    __swig_getmethods__["allocs"] = _libredwg.Dwg_Load_Stats_allocs_get
+    if _newclass:allocs = _swig_property(_libredwg.Dwg_Load_Stats_allocs_get, _libredwg.Dwg_Load_Stats_allocs_set)
+    __swig_setmethods__["alloc_bytes"] = _libredwg.Dwg_Load_Stats_alloc_bytes_set
+    __swig_getmethods__["alloc_bytes"] = _libredwg.Dwg_Load_Stats_alloc_bytes_get
+    if _newclass:alloc_bytes = _swig_property(_libredwg.Dwg_Load_Stats_alloc_bytes_get, _libredwg.Dwg_Load_Stats_alloc_bytes_set)
+    __swig_setmethods__["object_allocs"] = _libredwg.Dwg_Load_Stats_object_allocs_set
+    __swig_getmethods__["object_allocs"] = _libredwg.Dwg_Load_Stats_object_allocs_get
+    if _newclass:object_allocs = _swig_property(_libredwg.Dwg_Load_Stats_object_allocs_get, _libredwg.Dwg_Load_Stats_object_allocs_set)
+    __swig_setmethods__["refs_resolved"] = _libredwg.Dwg_Load_Stats_refs_resolved_set
+    __swig_getmethods__["refs_resolved"] = _libredwg.Dwg_Load_Stats_refs_resolved_get
+    if _newclass:refs_resolved = _swig_property(_libredwg.Dwg_Load_Stats_refs_resolved_get, _libredwg.Dwg_Load_Stats_refs_resolved_set)
+    __swig_setmethods__["refs_unresolved"] = _libredwg.Dwg_Load_Stats_refs_unresolved_set
+    __swig_getmethods__["refs_unresolved"] = _libredwg.Dwg_Load_Stats_refs_unresolved_get
+    if _newclass:refs_unresolved = _swig_property(_libredwg.Dwg_Load_Stats_refs_unresolved_get, _libredwg.Dwg_Load_Stats_refs_unresolved_set)
+    __swig_setmethods__["crc_failures"] = _libredwg.Dwg_Load_Stats_crc_failures_set
+    __swig_getmethods__["crc_failures"] = _libredwg.Dwg_Load_Stats_crc_failures_get
+    if _newclass:crc_failures = _swig_property(_libredwg.Dwg_Load_Stats_crc_failures_get, _libredwg.Dwg_Load_Stats_crc_failures_set)
+    def __init__(self): 
+        this = _libredwg.new_Dwg_Load_Stats()
+        try: self.this.append(this)
+        except: self.this = this
+    __swig_destroy__ = _libredwg.delete_Dwg_Load_Stats
+    __del__ = lambda self : None;
+Dwg_Load_Stats_swigregister = _libredwg.Dwg_Load_Stats_swigregister
+Dwg_Load_Stats_swigregister(Dwg_Load_Stats)
+
 class Dwg_Chain(_object):
     __swig_setmethods__ = {}
     __setattr__ = lambda self, name, value: _swig_setattr(self, Dwg_Chain, name, value)
@@ -7615,6 +7725,9 @@ class Dwg_Data(_object):
     __swig_setmethods__["num_objects"] = _libredwg.Dwg_Data_num_objects_set
     __swig_getmethods__["num_objects"] = _libredwg.Dwg_Data_num_objects_get
     if _newclass:num_objects = _swig_property(_libredwg.Dwg_Data_num_objects_get, _libredwg.Dwg_Data_num_objects_set)
+    __swig_setmethods__["num_alloced_objects"] = _libredwg.Dwg_Data_num_alloced_objects_set
+    __swig_getmethods__["num_alloced_objects"] = _libredwg.Dwg_Data_num_alloced_objects_get
+    if _newclass:num_alloced_objects = _swig_property(_libredwg.Dwg_Data_num_alloced_objects_get, _libredwg.Dwg_Data_num_alloced_objects_set)
     __swig_setmethods__["object"] = _libredwg.Dwg_Data_object_set
     __swig_getmethods__["object"] = _libredwg.Dwg_Data_object_get
     if _newclass:object = _swig_property(_libredwg.Dwg_Data_object_get, _libredwg.Dwg_Data_object_set)
@@ -7630,6 +7743,12 @@ class Dwg_Data(_object):
     __swig_setmethods__["object_ref"] = _libredwg.Dwg_Data_object_ref_set
     __swig_getmethods__["object_ref"] = _libredwg.Dwg_Data_object_ref_get
     if _newclass:object_ref = _swig_property(_libredwg.Dwg_Data_object_ref_get, _libredwg.Dwg_Data_object_ref_set)
+    __swig_setmethods__["num_handle_index"] = _libredwg.Dwg_Data_num_handle_index_set
+    __swig_getmethods__["num_handle_index"] = _libredwg.Dwg_Data_num_handle_index_get
+    if _newclass:num_handle_index = _swig_property(_libredwg.Dwg_Data_num_handle_index_get, _libredwg.Dwg_Data_num_handle_index_set)
+    __swig_setmethods__["handle_index"] = _libredwg.Dwg_Data_handle_index_set
+    __swig_getmethods__["handle_index"] = _libredwg.Dwg_Data_handle_index_get
+    if _newclass:handle_index = _swig_property(_libredwg.Dwg_Data_handle_index_get, _libredwg.Dwg_Data_handle_index_set)
     __swig_setmethods__["layer_control"] = _libredwg.Dwg_Data_layer_control_set
     __swig_getmethods__["layer_control"] = _libredwg.Dwg_Data_layer_control_get
     if _newclass:layer_control = _swig_property(_libredwg.Dwg_Data_layer_control_get, _libredwg.Dwg_Data_layer_control_set)
@@ -7642,6 +7761,27 @@ class Dwg_Data(_object):
     __swig_setmethods__["bit_chain"] = _libredwg.Dwg_Data_bit_chain_set
     __swig_getmethods__["bit_chain"] = _libredwg.Dwg_Data_bit_chain_get
     if _newclass:bit_chain = _swig_property(_libredwg.Dwg_Data_bit_chain_get, _libredwg.Dwg_Data_bit_chain_set)
+    __swig_setmethods__["stats"] = _libredwg.Dwg_Data_stats_set
+    __swig_getmethods__["stats"] = _libredwg.Dwg_Data_stats_get
+    if _newclass:stats = _swig_property(_libredwg.Dwg_Data_stats_get, _libredwg.Dwg_Data_stats_set)
+    __swig_setmethods__["opts"] = _libredwg.Dwg_Data_opts_set
+    __swig_getmethods__["opts"] = _libredwg.Dwg_Data_opts_get
+    if _newclass:opts = _swig_property(_libredwg.Dwg_Data_opts_get, _libredwg.Dwg_Data_opts_set)
+    __swig_setmethods__["arena"] = _libredwg.Dwg_Data_arena_set
+    __swig_getmethods__["arena"] = _libredwg.Dwg_Data_arena_get
+    if _newclass:arena = _swig_property(_libredwg.Dwg_Data_arena_get, _libredwg.Dwg_Data_arena_set)
+    __swig_setmethods__["read_options"] = _libredwg.Dwg_Data_read_options_set
+    __swig_getmethods__["read_options"] = _libredwg.Dwg_Data_read_options_get
+    if _newclass:read_options = _swig_property(_libredwg.Dwg_Data_read_options_get, _libredwg.Dwg_Data_read_options_set)
+    __swig_setmethods__["object_chain"] = _libredwg.Dwg_Data_object_chain_set
+    __swig_getmethods__["object_chain"] = _libredwg.Dwg_Data_object_chain_get
+    if _newclass:object_chain = _swig_property(_libredwg.Dwg_Data_object_chain_get, _libredwg.Dwg_Data_object_chain_set)
+    __swig_setmethods__["object_chain_size"] = _libredwg.Dwg_Data_object_chain_size_set
+    __swig_getmethods__["object_chain_size"] = _libredwg.Dwg_Data_object_chain_size_get
+    if _newclass:object_chain_size = _swig_property(_libredwg.Dwg_Data_object_chain_size_get, _libredwg.Dwg_Data_object_chain_size_set)
+    __swig_setmethods__["object_chain_owner"] = _libredwg.Dwg_Data_object_chain_owner_set
+    __swig_getmethods__["object_chain_owner"] = _libredwg.Dwg_Data_object_chain_owner_get
+    if _newclass:object_chain_owner = _swig_property(_libredwg.Dwg_Data_object_chain_owner_get, _libredwg.Dwg_Data_object_chain_owner_set)
     __swig_getmethods__["header"] = _libredwg.Dwg_Data_header_get
     if _newclass:header = _swig_property(_libredwg.Dwg_Data_header_get)
     __swig_getmethods__["second_header"] = _libredwg.Dwg_Data_second_header_get
@@ -7730,11 +7870,116 @@ class Dwg_Data_header(_object):
 Dwg_Data_header_swigregister = _libredwg.Dwg_Data_header_swigregister
 Dwg_Data_header_swigregister(Dwg_Data_header)
 
+DWG_OPT_MMAP = _libredwg.DWG_OPT_MMAP
+DWG_OPT_ARENA = _libredwg.DWG_OPT_ARENA
+DWG_OPT_FILTER = _libredwg.DWG_OPT_FILTER
+DWG_OPT_LAZY = _libredwg.DWG_OPT_LAZY
+DWG_OPT_THREADS = _libredwg.DWG_OPT_THREADS
+DWG_OPT_NO_CRC = _libredwg.DWG_OPT_NO_CRC
+DWG_OPT_STATS = _libredwg.DWG_OPT_STATS
+DWG_CHAIN_BORROWED = _libredwg.DWG_CHAIN_BORROWED
+DWG_CHAIN_MALLOCED = _libredwg.DWG_CHAIN_MALLOCED
+DWG_CHAIN_MAPPED = _libredwg.DWG_CHAIN_MAPPED
+class Dwg_Read_Options(_object):
+    __swig_setmethods__ = {}
+    __setattr__ = lambda self, name, value: _swig_setattr(self, Dwg_Read_Options, name, value)
+    __swig_getmethods__ = {}
+    __getattr__ = lambda self, name: _swig_getattr(self, Dwg_Read_Options, name)
+    __repr__ = _swig_repr
+    __swig_setmethods__["flags"] = _libredwg.Dwg_Read_Options_flags_set
+    __swig_getmethods__["flags"] = _libredwg.Dwg_Read_Options_flags_get
+    if _newclass:flags = _swig_property(_libredwg.Dwg_Read_Options_flags_get, _libredwg.Dwg_Read_Options_flags_set)
+    __swig_setmethods__["types"] = _libredwg.Dwg_Read_Options_types_set
+    __swig_getmethods__["types"] = _libredwg.Dwg_Read_Options_types_get
+    if _newclass:types = _swig_property(_libredwg.Dwg_Read_Options_types_get, _libredwg.Dwg_Read_Options_types_set)
+    __swig_setmethods__["classes"] = _libredwg.Dwg_Read_Options_classes_set
+    __swig_getmethods__["classes"] = _libredwg.Dwg_Read_Options_classes_get
+    if _newclass:classes = _swig_property(_libredwg.Dwg_Read_Options_classes_get, _libredwg.Dwg_Read_Options_classes_set)
+    __swig_setmethods__["num_threads"] = _libredwg.Dwg_Read_Options_num_threads_set
+    __swig_getmethods__["num_threads"] = _libredwg.Dwg_Read_Options_num_threads_get
+    if _newclass:num_threads = _swig_property(_libredwg.Dwg_Read_Options_num_threads_get, _libredwg.Dwg_Read_Options_num_threads_set)
+    __swig_setmethods__["batch_max_bytes"] = _libredwg.Dwg_Read_Options_batch_max_bytes_set
+    __swig_getmethods__["batch_max_bytes"] = _libredwg.Dwg_Read_Options_batch_max_bytes_get
+    if _newclass:batch_max_bytes = _swig_property(_libredwg.Dwg_Read_Options_batch_max_bytes_get, _libredwg.Dwg_Read_Options_batch_max_bytes_set)
+    def __init__(self): 
+        this = _libredwg.new_Dwg_Read_Options()
+        try: self.this.append(this)
+        except: self.this = this
+    __swig_destroy__ = _libredwg.delete_Dwg_Read_Options
+    __del__ = lambda self : None;
+Dwg_Read_Options_swigregister = _libredwg.Dwg_Read_Options_swigregister
+Dwg_Read_Options_swigregister(Dwg_Read_Options)
+
 
 def dwg_read_file(*args):
   return _libredwg.dwg_read_file(*args)
 dwg_read_file = _libredwg.dwg_read_file
 
+def dwg_read_file_ex(*args):
+  return _libredwg.dwg_read_file_ex(*args)
+dwg_read_file_ex = _libredwg.dwg_read_file_ex
+
+def dwg_read_buffer(*args):
+  return _libredwg.dwg_read_buffer(*args)
+dwg_read_buffer = _libredwg.dwg_read_buffer
+
+def dwg_read_fd(*args):
+  return _libredwg.dwg_read_fd(*args)
+dwg_read_fd = _libredwg.dwg_read_fd
+
+def dwg_read_file_opts(*args):
+  return _libredwg.dwg_read_file_opts(*args)
+dwg_read_file_opts = _libredwg.dwg_read_file_opts
+
+def dwg_read_buffer_opts(*args):
+  return _libredwg.dwg_read_buffer_opts(*args)
+dwg_read_buffer_opts = _libredwg.dwg_read_buffer_opts
+
+def dwg_read_fd_opts(*args):
+  return _libredwg.dwg_read_fd_opts(*args)
+dwg_read_fd_opts = _libredwg.dwg_read_fd_opts
+class Dwg_Batch_Result(_object):
+    __swig_setmethods__ = {}
+    __setattr__ = lambda self, name, value: _swig_setattr(self, Dwg_Batch_Result, name, value)
+    __swig_getmethods__ = {}
+    __getattr__ = lambda self, name: _swig_getattr(self, Dwg_Batch_Result, name)
+    __repr__ = _swig_repr
+    __swig_setmethods__["path"] = _libredwg.Dwg_Batch_Result_path_set
+    __swig_getmethods__["path"] = _libredwg.Dwg_Batch_Result_path_get
+    if _newclass:path = _swig_property(_libredwg.Dwg_Batch_Result_path_get, _libredwg.Dwg_Batch_Result_path_set)
+    __swig_setmethods__["index"] = _libredwg.Dwg_Batch_Result_index_set
+    __swig_getmethods__["index"] = _libredwg.Dwg_Batch_Result_index_get
+    if _newclass:index = _swig_property(_libredwg.Dwg_Batch_Result_index_get, _libredwg.Dwg_Batch_Result_index_set)
+    __swig_setmethods__["size"] = _libredwg.Dwg_Batch_Result_size_set
+    __swig_getmethods__["size"] = _libredwg.Dwg_Batch_Result_size_get
+    if _newclass:size = _swig_property(_libredwg.Dwg_Batch_Result_size_get, _libredwg.Dwg_Batch_Result_size_set)
+    __swig_setmethods__["error"] = _libredwg.Dwg_Batch_Result_error_set
+    __swig_getmethods__["error"] = _libredwg.Dwg_Batch_Result_error_get
+    if _newclass:error = _swig_property(_libredwg.Dwg_Batch_Result_error_get, _libredwg.Dwg_Batch_Result_error_set)
+    __swig_setmethods__["wait_time"] = _libredwg.Dwg_Batch_Result_wait_time_set
+    __swig_getmethods__["wait_time"] = _libredwg.Dwg_Batch_Result_wait_time_get
+    if _newclass:wait_time = _swig_property(_libredwg.Dwg_Batch_Result_wait_time_get, _libredwg.Dwg_Batch_Result_wait_time_set)
+    __swig_setmethods__["load_time"] = _libredwg.Dwg_Batch_Result_load_time_set
+    __swig_getmethods__["load_time"] = _libredwg.Dwg_Batch_Result_load_time_get
+    if _newclass:load_time = _swig_property(_libredwg.Dwg_Batch_Result_load_time_get, _libredwg.Dwg_Batch_Result_load_time_set)
+    def __init__(self): 
+        this = _libredwg.new_Dwg_Batch_Result()
+        try: self.this.append(this)
+        except: self.this = this
+    __swig_destroy__ = _libredwg.delete_Dwg_Batch_Result
+    __del__ = lambda self : None;
+Dwg_Batch_Result_swigregister = _libredwg.Dwg_Batch_Result_swigregister
+Dwg_Batch_Result_swigregister(Dwg_Batch_Result)
+
+
+def dwg_read_files_batch(*args):
+  return _libredwg.dwg_read_files_batch(*args)
+dwg_read_files_batch = _libredwg.dwg_read_files_batch
+
+def dwg_get_load_stats(*args):
+  return _libredwg.dwg_get_load_stats(*args)
+dwg_get_load_stats = _libredwg.dwg_get_load_stats
+
 def dwg_free(*args):
   return _libredwg.dwg_free(*args)
 dwg_free = _libredwg.dwg_free
@@ -7807,6 +8052,14 @@ def dwg_next_object(*args):
   return _libredwg.dwg_next_object(*args)
 dwg_next_object = _libredwg.dwg_next_object
 
+def dwg_find_object_by_handle(*args):
+  return _libredwg.dwg_find_object_by_handle(*args)
+dwg_find_object_by_handle = _libredwg.dwg_find_object_by_handle
+
+def dwg_get_object_decoded(*args):
+  return _libredwg.dwg_get_object_decoded(*args)
+dwg_get_object_decoded = _libredwg.dwg_get_object_decoded
+
 def dwg_get_object(*args):
   return _libredwg.dwg_get_object(*args)
 dwg_get_object = _libredwg.dwg_get_object
@@ -0,0 +1,377 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * bitread.c: check the bit_read_* functions against plain bit readers
+ *
+ * The readers take a word-level fast path when enough bytes follow the
+ * current one, and the byte-wise code otherwise.  Here each of them reads
+ * NUM_READS values of random bytes, from random bits, and must agree, in
+ * value and in the position it ends at, with a reference reader which
+ * takes the bits one at a time, as the format describes them.  Each
+ * value is read from a chain of its own size and up to 12 bytes more,
+ * so that the fast path is taken, or not, at every byte of it, and from
+ * the whole chain.  The exit status is 1 if a reader differs (see
+ * bitread.test).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dwg.h>
+#include "bits.h"
+
+/* Values read by each reader */
+#define NUM_READS 20000
+
+/* Bytes of random data */
+#define CHAIN_SIZE 4096
+
+/* Largest value, in bytes */
+#define MAX_BYTES 32
+
+enum { B, BB, FOURBITS, RC, RS, RL, RD, BS, BL, BD, MC, MS, DD, BT, BE, H,
+       L, NUM_READERS };
+
+static const char *names[] = {
+  "B", "BB", "4BITS", "RC", "RS", "RL", "RD", "BS", "BL", "BD", "MC", "MS",
+  "DD", "BT", "BE", "H", "L"
+};
+
+/* A value read: integers in i, doubles as their bytes in d */
+typedef struct _value
+{
+  long unsigned int i;
+  unsigned char d[3][8];
+} Value;
+
+static long unsigned int state = 88172645463325252UL;
+
+static long unsigned int
+random64(void)
+{
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+/* The reference readers, from bit number *pos of chain
+ */
+
+static long unsigned int
+ref_bits(const unsigned char *chain, long unsigned int *pos, int n)
+{
+  long unsigned int value = 0;
+
+  for (; n > 0; n--, (*pos)++)
+    value = value << 1 | (chain[*pos / 8] >> (7 - *pos % 8) & 1);
+  return value;
+}
+
+static long unsigned int
+ref_RS(const unsigned char *chain, long unsigned int *pos)
+{
+  long unsigned int low = ref_bits(chain, pos, 8);
+
+  return low | ref_bits(chain, pos, 8) << 8;
+}
+
+static long unsigned int
+ref_RL(const unsigned char *chain, long unsigned int *pos)
+{
+  long unsigned int low = ref_RS(chain, pos);
+
+  return low | ref_RS(chain, pos) << 16;
+}
+
+static void
+ref_RD(const unsigned char *chain, long unsigned int *pos, unsigned char d[8])
+{
+  int i;
+
+  for (i = 0; i < 8; i++)
+    d[i] = ref_bits(chain, pos, 8);
+}
+
+static void
+ref_BD(const unsigned char *chain, long unsigned int *pos, unsigned char d[8])
+{
+  double one = 1.0, zero = 0.0;
+
+  switch (ref_bits(chain, pos, 2))
+    {
+    case 0:
+      ref_RD(chain, pos, d);
+      break;
+    case 1:
+      memcpy(d, &one, 8);
+      break;
+    case 2:
+      memcpy(d, &zero, 8);
+      break;
+    default:
+      memset(d, 0xff, 8);   /* NaN */
+    }
+}
+
+static void
+ref_read(int reader, const unsigned char *chain, long unsigned int *pos,
+         double default_value, Value *value)
+{
+  long unsigned int byte, code, size;
+  double one = 1.0, zero = 0.0;
+  int i;
+
+  memset(value, 0, sizeof(Value));
+  switch (reader)
+    {
+    case B:
+      value->i = ref_bits(chain, pos, 1);
+      break;
+    case BB:
+      value->i = ref_bits(chain, pos, 2);
+      break;
+    case FOURBITS:
+      value->i = ref_bits(chain, pos, 4);
+      break;
+    case RC:
+      value->i = ref_bits(chain, pos, 8);
+      break;
+    case RS:
+      value->i = ref_RS(chain, pos);
+      break;
+    case RL:
+      value->i = ref_RL(chain, pos);
+      break;
+    case RD:
+      ref_RD(chain, pos, value->d[0]);
+      break;
+    case BS:
+    case BL:
+      code = ref_bits(chain, pos, 2);
+      if (code == 0)
+        value->i = reader == BS ? ref_RS(chain, pos) : ref_RL(chain, pos);
+      else if (code == 1)
+        value->i = ref_bits(chain, pos, 8);
+      else
+        value->i = code == 2 ? 0 : 256;
+      break;
+    case BD:
+      ref_BD(chain, pos, value->d[0]);
+      break;
+    case MC:
+      /* 7 bits a byte, least significant first, up to 4 bytes; the last
+         has the sign in bit 6.  */
+      for (i = 0; i < 4; i++)
+        {
+          byte = ref_bits(chain, pos, 8);
+          if (!(byte & 0x80))
+            {
+              value->i |= (byte & 0x3f) << (7 * i);
+              if (byte & 0x40)
+                value->i = -value->i;
+              return;
+            }
+          value->i |= (byte & 0x7f) << (7 * i);
+        }
+      value->i = 0;
+      break;
+    case MS:
+      for (i = 0; i < 2; i++)
+        {
+          byte = ref_RS(chain, pos);
+          value->i |= (byte & 0x7fff) << (15 * i);
+          if (!(byte & 0x8000))
+            return;
+        }
+      value->i = 0;
+      break;
+    case DD:
+      memcpy(value->d[0], &default_value, 8);
+      code = ref_bits(chain, pos, 2);
+      if (code == 3)
+        ref_RD(chain, pos, value->d[0]);
+      else if (code)
+        {
+          if (code == 2)
+            for (i = 4; i < 6; i++)
+              value->d[0][i] = ref_bits(chain, pos, 8);
+          for (i = 0; i < 4; i++)
+            value->d[0][i] = ref_bits(chain, pos, 8);
+        }
+      break;
+    case BT:
+      if (ref_bits(chain, pos, 1))
+        memcpy(value->d[0], &zero, 8);
+      else
+        ref_BD(chain, pos, value->d[0]);
+      break;
+    case BE:
+      if (ref_bits(chain, pos, 1))
+        {
+          memcpy(value->d[0], &zero, 8);
+          memcpy(value->d[1], &zero, 8);
+          memcpy(value->d[2], &one, 8);
+        }
+      else
+        for (i = 0; i < 3; i++)
+          ref_BD(chain, pos, value->d[i]);
+      break;
+    case H:
+      code = ref_bits(chain, pos, 4);
+      size = ref_bits(chain, pos, 4);
+      if (size > 4)
+        value->i = -1;
+      else
+        {
+          for (i = 0; i < (int) size; i++)
+            value->i = value->i << 8 | ref_bits(chain, pos, 8);
+          value->i = value->i << 8 | code << 4 | size;
+        }
+      break;
+    case L:
+      value->i = ref_bits(chain, pos, 32);
+      break;
+    }
+}
+
+/* The reader of the library, from dat
+ */
+static void
+lib_read(int reader, Bit_Chain *dat, double default_value, Value *value)
+{
+  double x, y, z;
+  Dwg_Handle handle;
+
+  memset(value, 0, sizeof(Value));
+  switch (reader)
+    {
+    case B:
+      value->i = bit_read_B(dat);
+      break;
+    case BB:
+      value->i = bit_read_BB(dat);
+      break;
+    case FOURBITS:
+      value->i = bit_read_4BITS(dat);
+      break;
+    case RC:
+      value->i = (unsigned char) bit_read_RC(dat);
+      break;
+    case RS:
+      value->i = bit_read_RS(dat);
+      break;
+    case RL:
+      value->i = bit_read_RL(dat);
+      break;
+    case RD:
+      x = bit_read_RD(dat);
+      memcpy(value->d[0], &x, 8);
+      break;
+    case BS:
+      value->i = bit_read_BS(dat);
+      break;
+    case BL:
+      value->i = bit_read_BL(dat);
+      break;
+    case BD:
+      x = bit_read_BD(dat);
+      memcpy(value->d[0], &x, 8);
+      break;
+    case MC:
+      value->i = bit_read_MC(dat);
+      break;
+    case MS:
+      value->i = bit_read_MS(dat);
+      break;
+    case DD:
+      x = bit_read_DD(dat, default_value);
+      memcpy(value->d[0], &x, 8);
+      break;
+    case BT:
+      x = bit_read_BT(dat);
+      memcpy(value->d[0], &x, 8);
+      break;
+    case BE:
+      bit_read_BE(dat, &x, &y, &z);
+      memcpy(value->d[0], &x, 8);
+      memcpy(value->d[1], &y, 8);
+      memcpy(value->d[2], &z, 8);
+      break;
+    case H:
+      if (bit_read_H(dat, &handle))
+        value->i = -1;
+      else
+        value->i = handle.value << 8 | handle.code << 4 | handle.size;
+      break;
+    case L:
+      value->i = bit_read_L(dat);
+      break;
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+  unsigned char *chain;
+  Bit_Chain dat;
+  Value expected, value;
+  long unsigned int start, end, n, extra;
+  double default_value;
+  int reader, failures = 0;
+
+  (void) argc;
+  (void) argv;
+  chain = (unsigned char *) malloc(CHAIN_SIZE);
+  if (!chain)
+    {
+      fprintf(stderr, "Out of memory\n");
+      return 1;
+    }
+  for (n = 0; n < CHAIN_SIZE; n++)
+    chain[n] = random64();
+
+  memset(&dat, 0, sizeof(dat));
+  dat.chain = chain;
+  dat.version = R_2000;
+  for (reader = 0; reader < NUM_READERS; reader++)
+    for (n = 0; n < NUM_READS; n++)
+      {
+        start = random64() % ((CHAIN_SIZE - MAX_BYTES) * 8);
+        default_value = (random64() >> 11) * (1.0 / (1UL << 53));
+        end = start;
+        ref_read(reader, chain, &end, default_value, &expected);
+
+        /* Chains ending 2 to 12 bytes after the last byte of the value,
+           then the whole chain.  */
+        for (extra = 2; extra <= 13; extra++)
+          {
+            dat.size = extra == 13 ? CHAIN_SIZE : end / 8 + extra;
+            dat.byte = start / 8;
+            dat.bit = start % 8;
+            lib_read(reader, &dat, default_value, &value);
+            if (memcmp(&value, &expected, sizeof(Value))
+                || dat.byte * 8 + dat.bit != end)
+              {
+                fprintf(stderr, "bit_read_%s differs at bit %lu, chain of "
+                        "%lu bytes\n", names[reader], start, dat.size);
+                failures++;
+                break;
+              }
+          }
+      }
+
+  free(chain);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,208 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * dwgbatch.c: load many DWGs at once, reporting on each as a JSON line
+ *
+ * Usage: dwgbatch [-j threads] [-m megabytes] [-s] [file ...]
+ *
+ * The files, or the paths read one per line from the standard input if
+ * none are given, are loaded by dwg_read_files_batch on the threads
+ * (one per processor by default), with at most the megabytes of files
+ * loading at once (no limit by default).  Each load is reported on
+ * the standard output, as it ends, by a line like
+ *
+ *   {"path":"a.dwg","index":0,"bytes":1234,"error":0,"wait_ms":0.012,
+ *    "load_ms":5.3,"objects":120,"entities":80}
+ *
+ * (on one line).  With -s, the files are loaded with DWG_OPT_STATS, and
+ * the statistics of each load (see dwg_get_load_stats) follow, as
+ *
+ *   "stats":{"locate_ms":0.1,...,"total_ms":5.2,"bytes_decompressed":0,
+ *    ...,"crc_failures":0,"types":{"19":42,...},"class_objects":3}
+ *
+ * the members of "types" being the object types, by number, and their
+ * counts.  The exit status is 1 if any file failed to load.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <dwg.h>
+
+/* Write s as a JSON string into out, of size at least 6 * strlen(s) + 3.
+ */
+static void
+json_string(char *out, const char *s)
+{
+  *out++ = '"';
+  for (; *s; s++)
+    if (*s == '"' || *s == '\\')
+      {
+        *out++ = '\\';
+        *out++ = *s;
+      }
+    else if ((unsigned char) *s < 0x20)
+      out += sprintf(out, "\\u%04x", (unsigned char) *s);
+    else
+      *out++ = *s;
+  *out++ = '"';
+  *out = '\0';
+}
+
+/* Print the statistics of the load of dwg, as members of its line.
+ */
+static void
+print_stats(Dwg_Data *dwg)
+{
+  Dwg_Load_Stats stats;
+  unsigned int type;
+  const char *separator = "";
+
+  dwg_get_load_stats(dwg, &stats);
+  printf(",\"stats\":{\"locate_ms\":%.3f,\"header_ms\":%.3f,"
+         "\"classes_ms\":%.3f,\"object_map_ms\":%.3f,\"objects_ms\":%.3f,"
+         "\"resolve_ms\":%.3f,\"total_ms\":%.3f,\"bytes_decompressed\":%lu,"
+         "\"allocs\":%lu,\"alloc_bytes\":%lu,\"refs_resolved\":%lu,"
+         "\"refs_unresolved\":%lu,\"crc_failures\":%lu,\"types\":{",
+         stats.locate_time * 1e3, stats.header_time * 1e3,
+         stats.classes_time * 1e3, stats.object_map_time * 1e3,
+         stats.objects_time * 1e3, stats.resolve_time * 1e3,
+         stats.total_time * 1e3, stats.bytes_decompressed, stats.allocs,
+         stats.alloc_bytes, stats.refs_resolved, stats.refs_unresolved,
+         stats.crc_failures);
+  for (type = 0; type <= DWG_TYPE_LAYOUT; type++)
+    if (stats.objects_by_type[type])
+      {
+        printf("%s\"%u\":%lu", separator, type, stats.objects_by_type[type]);
+        separator = ",";
+      }
+  printf("},\"class_objects\":%lu}", stats.class_objects);
+}
+
+/* Report on the load of dwg; data points to whether to print its
+ * statistics.  The loads end on several threads: the line is printed
+ * with stdout locked.
+ */
+static int
+report(Dwg_Data *dwg, const Dwg_Batch_Result *result, void *data)
+{
+  char *path = (char *) malloc(6 * strlen(result->path) + 3);
+
+  if (!path)
+    return 1;
+  json_string(path, result->path);
+  flockfile(stdout);
+  printf("{\"path\":%s,\"index\":%u,\"bytes\":%lu,\"error\":%d,"
+         "\"wait_ms\":%.3f,\"load_ms\":%.3f,\"objects\":%lu,"
+         "\"entities\":%lu", path, result->index, result->size,
+         result->error, result->wait_time * 1e3, result->load_time * 1e3,
+         result->error ? 0 : (long unsigned int) dwg->num_objects,
+         result->error ? 0 : (long unsigned int) dwg->num_entities);
+  if (*(int *) data && !result->error)
+    print_stats(dwg);
+  printf("}\n");
+  funlockfile(stdout);
+  free(path);
+  return 0;
+}
+
+/* Read the paths on stream, one per line, into a newly allocated vector,
+ * setting num_paths.
+ */
+static char **
+read_paths(FILE *stream, unsigned int *num_paths)
+{
+  char **paths = 0, **more;
+  char *line = 0;
+  size_t size = 0;
+  ssize_t length;
+  unsigned int max_paths = 0;
+
+  *num_paths = 0;
+  while ((length = getline(&line, &size, stream)) > 0)
+    {
+      if (line[length - 1] == '\n')
+        line[--length] = '\0';
+      if (!length)
+        continue;
+      if (*num_paths == max_paths)
+        {
+          max_paths = max_paths ? 2 * max_paths : 256;
+          more = (char **) realloc(paths, max_paths * sizeof(char *));
+          if (!more)
+            break;
+          paths = more;
+        }
+      paths[*num_paths] = strdup(line);
+      if (!paths[*num_paths])
+        break;
+      (*num_paths)++;
+    }
+  free(line);
+  return paths;
+}
+
+int
+main(int argc, char *argv[])
+{
+  Dwg_Read_Options options;
+  char **paths;
+  unsigned int num_paths, i;
+  int opt, failures, stats = 0;
+
+  memset(&options, 0, sizeof(options));
+  while ((opt = getopt(argc, argv, "j:m:s")) != -1)
+    switch (opt)
+      {
+      case 'j':
+        options.num_threads = atoi(optarg);
+        break;
+      case 'm':
+        options.batch_max_bytes = strtoul(optarg, 0, 10) * 1024 * 1024;
+        break;
+      case 's':
+        options.flags |= DWG_OPT_STATS;
+        stats = 1;
+        break;
+      default:
+        printf("Usage: %s [-j threads] [-m megabytes] [-s] [file ...]\n",
+               argv[0]);
+        return 1;
+      }
+
+  if (optind < argc)
+    {
+      paths = argv + optind;
+      num_paths = argc - optind;
+    }
+  else
+    paths = read_paths(stdin, &num_paths);
+
+  failures = dwg_read_files_batch(paths, num_paths, &options, report,
+                                  &stats);
+
+  if (paths != argv + optind)
+    {
+      for (i = 0; i < num_paths; i++)
+        free(paths[i]);
+      free(paths);
+    }
+  if (failures < 0)
+    {
+      fprintf(stderr, "Out of memory\n");
+      return 1;
+    }
+  return failures ? 1 : 0;
+}
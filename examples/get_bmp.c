@@ -52,16 +52,17 @@ get_bmp(char *filename)
 
   /* Get DIB bitmap data */
   data = dwg_bmp(&dwg, &size);
-  dwg_free(&dwg);
 
   if (!data)
     {
       puts("No thumb in dwg file");
+      dwg_free(&dwg);
       return -2;
     }
   if (size < 1)
     {
       puts("No thumb data in dwg file");
+      dwg_free(&dwg);
       return -3;
     }
 
@@ -71,6 +72,7 @@ get_bmp(char *filename)
     {
       printf ("Unable to write file '%s'\n", outfile);
       free (outfile);
+      dwg_free(&dwg);
       return -4;
     }
 
@@ -89,6 +91,7 @@ get_bmp(char *filename)
 
   printf ("Success! See the file '%s'\n", outfile);
   free (outfile);
+  dwg_free(&dwg);
   return success;
 }
 
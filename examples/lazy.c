@@ -0,0 +1,159 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * lazy.c: decode the objects a lazy or filtered load left out
+ *
+ * Each file is loaded in full, then lazily and with a read filter
+ * keeping only the lines, read or mapped, on one thread or several, and
+ * from a buffer freed as soon as the load returns.
+ * Every object of these loads must then decode on demand, through
+ * dwg_get_object_decoded, into the type, supertype and handle it has in
+ * the full load, and the drawing must end up with as many entities.
+ * The exit status is 1 if one differs (see lazy.test).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dwg.h>
+#include "suffix.c"
+
+static const unsigned int modes[] = {
+  DWG_OPT_LAZY,
+  DWG_OPT_LAZY | DWG_OPT_MMAP,
+  DWG_OPT_FILTER,
+  DWG_OPT_FILTER | DWG_OPT_MMAP,
+  DWG_OPT_FILTER | DWG_OPT_THREADS
+};
+#define NUM_MODES (sizeof(modes) / sizeof(modes[0]))
+
+/* Read filename into a buffer, to be freed.  Return NULL if it
+   cannot be read.  */
+static unsigned char *
+read_buffer(char *filename, size_t *size)
+{
+  FILE *fp;
+  unsigned char *buf;
+  long length;
+
+  fp = fopen(filename, "rb");
+  if (!fp)
+    return 0;
+  buf = 0;
+  if (!fseek(fp, 0, SEEK_END) && (length = ftell(fp)) > 0
+      && !fseek(fp, 0, SEEK_SET) && (buf = malloc(length)))
+    {
+      *size = fread(buf, 1, length, fp);
+      if (*size != (size_t) length)
+        {
+          free(buf);
+          buf = 0;
+        }
+    }
+  fclose(fp);
+  return buf;
+}
+
+/* Load filename with the flags, from a buffer freed at once if buffer
+   is set, and decode all its objects against those of full.  Return
+   the number of differences.  */
+static int
+check_load(char *filename, unsigned int flags, int buffer, Dwg_Data *full)
+{
+  Dwg_Read_Options options;
+  Dwg_Data dwg;
+  Dwg_Object *obj, *expected;
+  unsigned char *buf;
+  size_t size;
+  long unsigned int i;
+  int failures = 0, error;
+
+  memset(&options, 0, sizeof(options));
+  options.flags = flags;
+  options.num_threads = 2;
+  DWG_FILTER_TYPE(&options, DWG_TYPE_LINE);
+  if (buffer)
+    {
+      buf = read_buffer(filename, &size);
+      if (!buf)
+        {
+          printf("Could not read %s\n", filename);
+          return 1;
+        }
+      error = dwg_read_buffer_opts(buf, size, &dwg, &options);
+      free(buf);
+    }
+  else
+    error = dwg_read_file_opts(filename, &dwg, &options);
+  if (error)
+    {
+      printf("Could not load %s with flags 0x%x\n", filename, flags);
+      return 1;
+    }
+
+  if (dwg.num_objects != full->num_objects)
+    failures++;
+  for (i = 0; i < dwg.num_objects && i < full->num_objects; i++)
+    {
+      obj = dwg_get_object_decoded(&dwg, i);
+      expected = &full->object[i];
+      if (!obj || obj->type != expected->type
+          || obj->supertype != expected->supertype
+          || obj->handle.value != expected->handle.value)
+        {
+          printf("%s, flags 0x%x: object %lu differs\n", filename, flags, i);
+          failures++;
+        }
+    }
+  if (dwg.num_entities != full->num_entities)
+    {
+      printf("%s, flags 0x%x: %lu entities instead of %lu\n", filename,
+             flags, (long unsigned int) dwg.num_entities,
+             (long unsigned int) full->num_entities);
+      failures++;
+    }
+
+  dwg_free(&dwg);
+  return failures;
+}
+
+int
+main(int argc, char *argv[])
+{
+  Dwg_Data full;
+  unsigned int mode;
+  int i, failures = 0;
+
+  REQUIRE_INPUT_FILE_ARG (argc);
+  for (i = 1; i < argc; i++)
+    {
+      if (dwg_read_file(argv[i], &full))
+        {
+          printf("Could not load %s\n", argv[i]);
+          return 1;
+        }
+      for (mode = 0; mode < NUM_MODES; mode++)
+        failures += check_load(argv[i], modes[mode], 0, &full);
+      failures += check_load(argv[i], DWG_OPT_LAZY, 1, &full);
+      failures += check_load(argv[i], DWG_OPT_FILTER, 1, &full);
+      dwg_free(&full);
+    }
+
+  if (failures)
+    {
+      printf("%d differences\n", failures);
+      return 1;
+    }
+  return 0;
+}
@@ -0,0 +1,145 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * load_threads.c: load DWGs from several threads at once
+ *
+ * NUM_THREADS threads load all the files LOADS times over, each starting
+ * with a different file, half of them with DWG_OPT_THREADS.  These are
+ * the first loads of the process.  Then each file is loaded once more,
+ * alone, and every load must have found the objects and entities of
+ * that one.  Built with -fsanitize=thread, this checks that the decodes
+ * share no state (see race.test).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <dwg.h>
+#include "suffix.c"
+
+#define NUM_THREADS 16
+
+/* Loads of each file per thread */
+#define LOADS 4
+
+typedef struct _load_thread
+{
+  int index;
+  int num_files;
+  char **files;
+
+  /* Counts of each file, as first loaded by the thread */
+  long unsigned int *num_objects;
+  long unsigned int *num_entities;
+  int failures;
+} Load_Thread;
+
+/* Load filename with the flags, setting the counts of its objects and
+   entities.  Return the result of the load.  */
+static int
+load(char *filename, unsigned int flags, long unsigned int *num_objects,
+     long unsigned int *num_entities)
+{
+  Dwg_Read_Options options;
+  Dwg_Data dwg;
+  int error;
+
+  memset(&options, 0, sizeof(options));
+  options.flags = flags;
+  options.num_threads = 2;
+  error = dwg_read_file_opts(filename, &dwg, &options);
+  *num_objects = dwg.num_objects;
+  *num_entities = dwg.num_entities;
+  dwg_free(&dwg);
+  return error;
+}
+
+static void *
+load_files(void *data)
+{
+  Load_Thread *thread = (Load_Thread *) data;
+  unsigned int flags = thread->index % 2 ? DWG_OPT_THREADS : 0;
+  long unsigned int num_objects, num_entities;
+  int i, j;
+
+  for (i = 0; i < LOADS * thread->num_files; i++)
+    {
+      j = (thread->index + i) % thread->num_files;
+      if (load(thread->files[j], flags, &num_objects, &num_entities))
+        thread->failures++;
+      else if (i < thread->num_files)
+        {
+          thread->num_objects[j] = num_objects;
+          thread->num_entities[j] = num_entities;
+        }
+      else if (num_objects != thread->num_objects[j]
+               || num_entities != thread->num_entities[j])
+        thread->failures++;
+    }
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  Load_Thread threads[NUM_THREADS];
+  pthread_t ids[NUM_THREADS];
+  int num_files = argc - 1;
+  long unsigned int num_objects[NUM_THREADS][argc];
+  long unsigned int num_entities[NUM_THREADS][argc];
+  long unsigned int objects, entities;
+  int i, j, failures = 0;
+
+  REQUIRE_INPUT_FILE_ARG (argc);
+  memset(num_objects, 0, sizeof(num_objects));
+  memset(num_entities, 0, sizeof(num_entities));
+  for (i = 0; i < NUM_THREADS; i++)
+    {
+      threads[i].index = i;
+      threads[i].num_files = num_files;
+      threads[i].files = argv + 1;
+      threads[i].num_objects = num_objects[i];
+      threads[i].num_entities = num_entities[i];
+      threads[i].failures = 0;
+      if (pthread_create(&ids[i], 0, load_files, &threads[i]))
+        {
+          printf("Could not start thread %d\n", i);
+          return 1;
+        }
+    }
+  for (i = 0; i < NUM_THREADS; i++)
+    {
+      pthread_join(ids[i], 0);
+      failures += threads[i].failures;
+    }
+
+  for (j = 0; j < num_files; j++)
+    {
+      if (load(argv[j + 1], 0, &objects, &entities))
+        {
+          printf("Could not load %s\n", argv[j + 1]);
+          return 1;
+        }
+      for (i = 0; i < NUM_THREADS; i++)
+        if (num_objects[i][j] != objects || num_entities[i][j] != entities)
+          failures++;
+    }
+
+  if (failures)
+    {
+      printf("%d loads failed or differ\n", failures);
+      return 1;
+    }
+  return 0;
+}
@@ -0,0 +1,337 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * roundtrip.c: check that what the writers write reads back
+ *
+ * NUM_VALUES pseudo-random values, each of a primitive drawn at random,
+ * are written one after the other by the bit_write_* functions, from
+ * each bit of the first byte in turn, then read back by the bit_read_*
+ * functions and compared.  The integers are of random widths, so that
+ * the short and long codes of the compressed types are all taken.
+ *
+ * Then each drawing named on the command line is loaded, encoded in
+ * memory and loaded again from there: it must have the same objects,
+ * of the same types and handles, and no section whose CRC does not
+ * match.  The exit status is 1 if a value or an
+ * object differs (see roundtrip.test).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dwg.h>
+#include "bits.h"
+#include "encode.h"
+
+/* Values written */
+#define NUM_VALUES 200000
+
+/* Largest value written, in bytes */
+#define MAX_BYTES 40
+
+static const char *names[] = {
+  "B", "BB", "4BITS", "RC", "RS", "RL", "RD", "BS", "BL", "BD", "MC", "MS",
+  "BE", "DD", "BT", "H", "TV", "L", "CMC"
+};
+#define NUM_PRIMITIVES (sizeof(names) / sizeof(names[0]))
+
+static char *texts[] = {
+  "", "0", "Standard", "ByLayer", "*Model_Space", "ACAD_GROUP",
+  "A somewhat longer text, as of an MTEXT entity", "CONTINUOUS"
+};
+
+static long unsigned int state;
+
+static long unsigned int
+random64(void)
+{
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+/* Up to 32 bits, of a random width */
+static long unsigned int
+random_int(void)
+{
+  long unsigned int r = random64();
+
+  return (random64() >> 32) >> (r & 31);
+}
+
+/* 0.0, 1.0 or anything, as the defaults of the bit doubles */
+static double
+random_double(void)
+{
+  switch (random64() & 3)
+    {
+    case 0:
+      return 0.0;
+    case 1:
+      return 1.0;
+    default:
+      return ((random64() >> 11) * (1.0 / (1UL << 53)) - 0.5) * 2000.0;
+    }
+}
+
+/* The default of value for a bit double with default: the value, or
+   the value with its first 2 or 4 bytes changed, or anything.  */
+static double
+random_default(double value)
+{
+  unsigned char a[8], b[8];
+  double other = random_double();
+  int bytes = random64() & 3;
+
+  if (bytes == 3)
+    return other;
+  memcpy(a, &value, 8);
+  memcpy(b, &other, 8);
+  memcpy(a, b, bytes * 2);
+  memcpy(&value, a, 8);
+  return value;
+}
+
+/* Write the values of seed into dat, or read them back if reading and
+ * compare them.  Returns the number of the first value that differs,
+ * plus one, or 0.
+ */
+static long unsigned int
+pass(Bit_Chain *dat, long unsigned int seed, int reading)
+{
+  long unsigned int i, v;
+  long int mc;
+  double x, y, z, rx, ry, rz;
+  Dwg_Handle handle, read_handle;
+  Dwg_Color color, read_color;
+  unsigned char *text;
+  unsigned int kind;
+  int differs;
+
+  state = seed;
+  for (i = 0; i < NUM_VALUES; i++)
+    {
+      kind = random64() % NUM_PRIMITIVES;
+      v = random_int();
+      x = random_double();
+      differs = 0;
+      switch (kind)
+        {
+#define INTEGER(index, name, mask) \
+        case index: \
+          if (reading) \
+            differs = (bit_read_##name(dat) & (mask)) != (v & (mask)); \
+          else \
+            bit_write_##name(dat, v & (mask)); \
+          break;
+#define DOUBLE(index, name) \
+        case index: \
+          if (reading) \
+            differs = bit_read_##name(dat) != x; \
+          else \
+            bit_write_##name(dat, x); \
+          break;
+        INTEGER(0, B, 1)
+        INTEGER(1, BB, 3)
+        INTEGER(2, 4BITS, 0xF)
+        INTEGER(3, RC, 0xFF)
+        INTEGER(4, RS, 0xFFFF)
+        INTEGER(5, RL, 0xFFFFFFFF)
+        DOUBLE(6, RD)
+        INTEGER(7, BS, 0xFFFF)
+        INTEGER(8, BL, 0xFFFFFFFF)
+        DOUBLE(9, BD)
+        case 10:
+          /* 4 bytes at most: 27 bits and the sign */
+          mc = (v >> 1) & 0x7FFFFFF;
+          if (v & 1)
+            mc = -mc;
+          if (reading)
+            differs = bit_read_MC(dat) != mc;
+          else
+            bit_write_MC(dat, mc);
+          break;
+        INTEGER(11, MS, 0x7FFF)
+        case 12:
+          y = random_double();
+          z = random_double();
+          if (reading)
+            {
+              bit_read_BE(dat, &rx, &ry, &rz);
+              differs = rx != x || ry != y || rz != z;
+            }
+          else
+            bit_write_BE(dat, x, y, z);
+          break;
+        case 13:
+          y = random_default(x);
+          if (reading)
+            differs = bit_read_DD(dat, y) != x;
+          else
+            bit_write_DD(dat, x, y);
+          break;
+        DOUBLE(14, BT)
+        case 15:
+          handle.code = random64() & 0xF;
+          handle.value = v;
+          if (reading)
+            differs = bit_read_H(dat, &read_handle)
+              || read_handle.code != handle.code
+              || read_handle.value != handle.value;
+          else
+            bit_write_H(dat, &handle);
+          break;
+        case 16:
+          if (reading)
+            {
+              text = bit_read_TV(dat);
+              differs = strcmp((char *) text, texts[v & 7]) != 0;
+              free(text);
+            }
+          else
+            bit_write_TV(dat, (unsigned char *) texts[v & 7]);
+          break;
+        INTEGER(17, L, 0xFFFFFFFF)
+        case 18:
+          memset(&color, 0, sizeof(color));
+          color.index = v & 0xFFFF;
+          if (reading)
+            {
+              bit_read_CMC(dat, &read_color);
+              differs = read_color.index != color.index;
+            }
+          else
+            bit_write_CMC(dat, &color);
+          break;
+        }
+      if (differs)
+        {
+          fprintf(stderr, "value %lu (%s) differs\n", i, names[kind]);
+          return i + 1;
+        }
+    }
+  return 0;
+}
+
+/* Round trip the primitives, from each bit of the first byte.
+ */
+static int
+round_trip_primitives(void)
+{
+  Bit_Chain dat;
+  unsigned char bit;
+  int failures = 0;
+
+  memset(&dat, 0, sizeof(dat));
+  dat.version = R_2000;
+  dat.size = NUM_VALUES * MAX_BYTES;
+  dat.chain = (unsigned char *) calloc(dat.size, 1);
+  if (!dat.chain)
+    {
+      fprintf(stderr, "Out of memory\n");
+      return 1;
+    }
+  for (bit = 0; bit < 8; bit++)
+    {
+      dat.byte = 0;
+      dat.bit = bit;
+      pass(&dat, 88172645463325252UL + bit, 0);
+      dat.byte = 0;
+      dat.bit = bit;
+      if (pass(&dat, 88172645463325252UL + bit, 1))
+        failures++;
+    }
+  free(dat.chain);
+  return failures;
+}
+
+/* Encode the drawing in filename, and load it back from what was
+ * written.  Returns the number of differences.
+ */
+static int
+round_trip_drawing(char *filename)
+{
+  Dwg_Data dwg, written;
+  Bit_Chain dat;
+  Dwg_Object *obj, *expected;
+  long unsigned int i;
+  int failures = 0;
+
+  if (dwg_read_file(filename, &dwg))
+    {
+      fprintf(stderr, "Could not load %s\n", filename);
+      return 1;
+    }
+  memset(&dat, 0, sizeof(dat));
+  dat.version = dwg.header.version;
+  if (dwg_encode_chains(&dwg, &dat))
+    {
+      fprintf(stderr, "Could not encode %s\n", filename);
+      dwg_free(&dwg);
+      free(dat.chain);
+      return 1;
+    }
+  if (dwg_read_buffer(dat.chain, dat.byte, &written))
+    {
+      fprintf(stderr, "Could not load %s as written\n", filename);
+      dwg_free(&dwg);
+      free(dat.chain);
+      return 1;
+    }
+
+  if (written.stats.crc_failures)
+    {
+      fprintf(stderr, "%s: %lu CRC failures once written\n", filename,
+              (long unsigned int) written.stats.crc_failures);
+      failures++;
+    }
+  if (written.num_objects != dwg.num_objects)
+    {
+      fprintf(stderr, "%s: %lu objects written, %lu read back\n",
+              filename, (long unsigned int) dwg.num_objects,
+              (long unsigned int) written.num_objects);
+      failures++;
+    }
+  for (i = 0; i < written.num_objects && i < dwg.num_objects; i++)
+    {
+      obj = &written.object[i];
+      expected = &dwg.object[i];
+      if (obj->type != expected->type
+          || obj->supertype != expected->supertype
+          || obj->handle.value != expected->handle.value)
+        {
+          fprintf(stderr, "%s: object %lu differs\n", filename, i);
+          failures++;
+        }
+    }
+
+  dwg_free(&written);
+  dwg_free(&dwg);
+  free(dat.chain);
+  return failures;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, failures;
+
+  failures = round_trip_primitives();
+  for (i = 1; i < argc; i++)
+    failures += round_trip_drawing(argv[i]);
+  if (failures)
+    return 1;
+  return 0;
+}
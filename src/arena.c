@@ -0,0 +1,221 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * arena.c: slab allocator owning the decoded data of a drawing
+ *
+ * The decoder makes a great many small allocations per object: the
+ * entity struct, every string, vector and handle reference.  With an
+ * arena they are carved out of a few large slabs instead, and are all
+ * released together when the drawing is freed.
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+/* Alignment of every block handed out, enough for any field type.  */
+#define ARENA_ALIGN 16
+
+/* The first slab is ARENA_MIN_SLAB bytes, and each following one twice
+ * the previous size, up to ARENA_MAX_SLAB.  */
+#define ARENA_MIN_SLAB (16 * 1024)
+#define ARENA_MAX_SLAB (1024 * 1024)
+
+/* Blocks larger than this get a slab of their own.  */
+#define ARENA_MAX_BLOCK (ARENA_MAX_SLAB / 4)
+
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1))
+
+typedef struct _dwg_slab
+{
+  struct _dwg_slab *next;
+  size_t size;
+  size_t used;
+} Dwg_Slab;
+
+/* Blocks start this far into a slab, past its header.  */
+#define SLAB_HEADER ARENA_ROUND(sizeof(Dwg_Slab))
+
+struct _dwg_arena
+{
+  Dwg_Slab *slab;
+  size_t slab_size;
+};
+
+static Dwg_Slab *
+slab_new(size_t size)
+{
+  Dwg_Slab *slab;
+
+  if (size > (size_t) -1 - SLAB_HEADER)
+    return 0;
+  slab = (Dwg_Slab *) malloc(SLAB_HEADER + size);
+  if (!slab)
+    return 0;
+  slab->next = 0;
+  slab->size = size;
+  slab->used = 0;
+  return slab;
+}
+
+/* Create an empty arena.
+ */
+Dwg_Arena *
+dwg_arena_new(void)
+{
+  Dwg_Arena *arena;
+
+  arena = (Dwg_Arena *) malloc(sizeof(Dwg_Arena));
+  if (!arena)
+    return 0;
+  arena->slab = 0;
+  arena->slab_size = ARENA_MIN_SLAB;
+  return arena;
+}
+
+/* Allocate size bytes from arena.  The memory is not initialized, and
+ * lives until the arena is destroyed.
+ */
+void *
+dwg_arena_alloc(Dwg_Arena * arena, size_t size)
+{
+  Dwg_Slab *slab = arena->slab;
+  void *ptr;
+
+  if (size > ARENA_MAX_BLOCK)
+    {
+      /* Too big to share a slab: give it one of its own, behind the
+         current slab so that the free space there stays in use.  */
+      slab = slab_new(size);
+      if (!slab)
+        return 0;
+      slab->used = size;
+      if (arena->slab)
+        {
+          slab->next = arena->slab->next;
+          arena->slab->next = slab;
+        }
+      else
+        arena->slab = slab;
+      return (unsigned char *) slab + SLAB_HEADER;
+    }
+
+  size = ARENA_ROUND(size);
+  if (!slab || slab->size - slab->used < size)
+    {
+      while (arena->slab_size < size)
+        arena->slab_size *= 2;
+      slab = slab_new(arena->slab_size);
+      if (!slab)
+        return 0;
+      slab->next = arena->slab;
+      arena->slab = slab;
+      if (arena->slab_size < ARENA_MAX_SLAB)
+        arena->slab_size *= 2;
+    }
+
+  ptr = (unsigned char *) slab + SLAB_HEADER + slab->used;
+  slab->used += size;
+  return ptr;
+}
+
+/* Release arena and every block allocated from it.
+ */
+void
+dwg_arena_destroy(Dwg_Arena * arena)
+{
+  Dwg_Slab *slab, *next;
+
+  if (!arena)
+    return;
+  for (slab = arena->slab; slab; slab = next)
+    {
+      next = slab->next;
+      free(slab);
+    }
+  free(arena);
+}
+
+/* Move the blocks of from into arena, and destroy from.  The blocks
+ * then live until arena is destroyed.
+ */
+void
+dwg_arena_merge(Dwg_Arena * arena, Dwg_Arena * from)
+{
+  Dwg_Slab *last;
+
+  if (from->slab)
+    {
+      /* Behind the current slab of arena, which keeps on serving.  */
+      for (last = from->slab; last->next; last = last->next)
+        ;
+      if (arena->slab)
+        {
+          last->next = arena->slab->next;
+          arena->slab->next = from->slab;
+        }
+      else
+        arena->slab = from->slab;
+    }
+  free(from);
+}
+
+void *
+dwg_malloc(Dwg_Data * dwg, size_t size)
+{
+  dwg->stats.allocs++;
+  dwg->stats.alloc_bytes += size;
+  if (dwg->arena)
+    return dwg_arena_alloc(dwg->arena, size);
+  return malloc(size);
+}
+
+void *
+dwg_calloc(Dwg_Data * dwg, size_t nmemb, size_t size)
+{
+  void *ptr;
+
+  dwg->stats.allocs++;
+  dwg->stats.alloc_bytes += nmemb * size;
+  if (!dwg->arena)
+    return calloc(nmemb, size);
+  if (size && nmemb > (size_t) -1 / size)
+    return 0;
+  ptr = dwg_arena_alloc(dwg->arena, nmemb * size);
+  if (ptr)
+    memset(ptr, 0, nmemb * size);
+  return ptr;
+}
+
+/* Resize ptr, a block of oldsize bytes, to size bytes.  A block cannot
+ * grow in place in the arena, so it is copied to a new one; the old one
+ * is only reclaimed with the whole arena.
+ */
+void *
+dwg_realloc(Dwg_Data * dwg, void *ptr, size_t oldsize, size_t size)
+{
+  void *block;
+
+  dwg->stats.allocs++;
+  dwg->stats.alloc_bytes += size;
+  if (!dwg->arena)
+    return realloc(ptr, size);
+  if (ptr && size <= oldsize)
+    return ptr;
+  block = dwg_arena_alloc(dwg->arena, size);
+  if (block && ptr)
+    memcpy(block, ptr, oldsize);
+  return block;
+}
@@ -0,0 +1,51 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * arena.h: slab allocator owning the decoded data of a drawing
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#include "dwg.h"
+
+typedef struct _dwg_arena Dwg_Arena;
+
+Dwg_Arena *
+dwg_arena_new(void);
+
+void *
+dwg_arena_alloc(Dwg_Arena * arena, size_t size);
+
+void
+dwg_arena_destroy(Dwg_Arena * arena);
+
+void
+dwg_arena_merge(Dwg_Arena * arena, Dwg_Arena * from);
+
+/* Allocators for the decoded data of dwg.  They take their memory from
+ * dwg->arena when the drawing has one, and from the C library otherwise.
+ */
+
+void *
+dwg_malloc(Dwg_Data * dwg, size_t size);
+
+void *
+dwg_calloc(Dwg_Data * dwg, size_t nmemb, size_t size);
+
+void *
+dwg_realloc(Dwg_Data * dwg, void *ptr, size_t oldsize, size_t size);
+
+#endif
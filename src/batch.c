@@ -0,0 +1,217 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * batch.c: loading many files at once
+ *
+ * The files are loaded each as one task of dwg_run_tasks, largest first
+ * (by their size from stat), so that a large file is not left to finish
+ * alone at the end: threads done early take over the smaller ones.  A
+ * file starts loading only when its size fits in what is left of the
+ * byte budget of the batch, in the order of the tasks, so that a large
+ * file waiting for memory is not overtaken forever.
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <sys/stat.h>
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include "dwg.h"
+#include "stats.h"
+#include "threads.h"
+
+typedef struct _batch_file
+{
+  char *path;
+  unsigned int index;
+  long unsigned int size;
+} Batch_File;
+
+typedef struct _batch
+{
+  Batch_File *file;
+  const Dwg_Read_Options *options;
+  Dwg_Read_Options file_options;
+  Dwg_Batch_Callback callback;
+  void *data;
+  long unsigned int max_bytes;
+
+  /* Bytes of the files loading, and the next file to start */
+  long unsigned int loading;
+  unsigned int next_file;
+  int stop;
+  int failures;
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD)
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+#endif
+} Batch;
+
+/* Largest first, in the order of the paths for equal sizes.
+ */
+static int
+compare_files(const void *a, const void *b)
+{
+  const Batch_File *file_a = (const Batch_File *) a;
+  const Batch_File *file_b = (const Batch_File *) b;
+
+  if (file_a->size != file_b->size)
+    return file_a->size > file_b->size ? -1 : 1;
+  return file_a->index < file_b->index ? -1 : file_a->index > file_b->index;
+}
+
+/* Wait until file i may start: the files before it have, and it fits in
+ * the budget, or nothing else is loading.  Returns -1 if the batch was
+ * stopped instead.
+ */
+static int
+admit_file(Batch *batch, unsigned int i)
+{
+  long unsigned int size = batch->file[i].size;
+  int admitted;
+
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD)
+  pthread_mutex_lock(&batch->lock);
+  while (!batch->stop
+         && (batch->next_file != i
+             || (batch->max_bytes && batch->loading
+                 && batch->loading + size > batch->max_bytes)))
+    pthread_cond_wait(&batch->changed, &batch->lock);
+#endif
+  admitted = !batch->stop;
+  if (admitted)
+    {
+      batch->loading += size;
+      batch->next_file++;
+    }
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD)
+  pthread_cond_broadcast(&batch->changed);
+  pthread_mutex_unlock(&batch->lock);
+#endif
+  return admitted ? 0 : -1;
+}
+
+/* Give back the budget of file i, once loaded and freed.
+ */
+static void
+release_file(Batch *batch, unsigned int i, int failed, int stop)
+{
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD)
+  pthread_mutex_lock(&batch->lock);
+#endif
+  batch->loading -= batch->file[i].size;
+  batch->failures += failed;
+  if (stop)
+    batch->stop = 1;
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD)
+  pthread_cond_broadcast(&batch->changed);
+  pthread_mutex_unlock(&batch->lock);
+#endif
+}
+
+/* Task loading file i, and handing it to the callback.
+ */
+static void
+load_file(void *data, unsigned int i)
+{
+  Batch *batch = (Batch *) data;
+  Dwg_Batch_Result result;
+  Dwg_Data dwg;
+  double start = dwg_clock();
+  int stop = 0;
+
+  if (admit_file(batch, i))
+    return;
+
+  result.path = batch->file[i].path;
+  result.index = batch->file[i].index;
+  result.size = batch->file[i].size;
+  result.wait_time = dwg_clock() - start;
+  start = dwg_clock();
+  result.error = dwg_read_file_opts(batch->file[i].path, &dwg,
+                                    batch->options);
+  result.load_time = dwg_clock() - start;
+
+  if (batch->callback)
+    stop = batch->callback(&dwg, &result, batch->data);
+  dwg_free(&dwg);
+  release_file(batch, i, result.error != 0, stop);
+}
+
+/* Load the num_paths files at paths with the read options, which may be
+ * NULL, on num_threads threads of the options (one per processor if 0
+ * or without options), and call callback on each drawing.  At most
+ * batch_max_bytes of files (if not 0) load at once, but for a file
+ * larger than that, which loads alone.  Returns the number of files
+ * that failed to load, or -1 if out of memory.
+ */
+int
+dwg_read_files_batch(char **paths, unsigned int num_paths,
+                     const Dwg_Read_Options * options,
+                     Dwg_Batch_Callback callback, void *data)
+{
+  Batch batch;
+  struct stat attrib;
+  unsigned int i, num_threads = 0;
+  int error;
+
+  if (num_paths == 0)
+    return 0;
+  batch.file = (Batch_File *) malloc(num_paths * sizeof(Batch_File));
+  if (!batch.file)
+    return -1;
+  for (i = 0; i < num_paths; i++)
+    {
+      batch.file[i].path = paths[i];
+      batch.file[i].index = i;
+      batch.file[i].size = stat(paths[i], &attrib) ? 0 : attrib.st_size;
+    }
+  qsort(batch.file, num_paths, sizeof(Batch_File), compare_files);
+
+  batch.options = options;
+  batch.callback = callback;
+  batch.data = data;
+  batch.max_bytes = options ? options->batch_max_bytes : 0;
+  batch.loading = 0;
+  batch.next_file = 0;
+  batch.stop = 0;
+  batch.failures = 0;
+  if (options)
+    num_threads = options->num_threads;
+  if (num_threads == 0)
+    num_threads = dwg_num_processors();
+
+  /* The files already load on several threads: each decoding on as
+     many more would make num_threads times too many.  */
+  if (options && num_threads > 1 && num_paths > 1)
+    {
+      batch.file_options = *options;
+      batch.file_options.flags &= ~DWG_OPT_THREADS;
+      batch.options = &batch.file_options;
+    }
+
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD)
+  pthread_mutex_init(&batch.lock, 0);
+  pthread_cond_init(&batch.changed, 0);
+#endif
+  error = dwg_run_tasks(load_file, &batch, num_paths, num_threads);
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD)
+  pthread_cond_destroy(&batch.changed);
+  pthread_mutex_destroy(&batch.lock);
+#endif
+
+  free(batch.file);
+  return error ? -1 : batch.failures;
+}
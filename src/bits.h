@@ -35,6 +35,16 @@
 
 #include "common.h"
 
+/**
+ State of one decode, that would otherwise be global: each decode sets
+ up its own, and its chains carry it along, so that several drawings can
+ be decoded at once
+ */
+typedef struct _decode_context
+{
+  unsigned int loglevel;
+} Decode_Context;
+
 /**
  Structure for DWG-files raw data storage
  */
@@ -45,6 +55,7 @@ typedef struct _bit_chain
   long unsigned int byte;
   unsigned char bit;
   Dwg_Version_Type version;
+  Decode_Context context;
 } Bit_Chain;
 
 /* Functions for raw data manipulations.
@@ -161,6 +172,9 @@ unsigned int
 bit_write_CRC(Bit_Chain * dat, long unsigned int start_address,
     unsigned int semo);
 
+void
+bit_read_text(Bit_Chain * dat, unsigned char *chain, unsigned int length);
+
 unsigned char *
 bit_read_TV(Bit_Chain * dat);
 
@@ -182,12 +196,19 @@ bit_write_CMC(Bit_Chain * dat, Dwg_Color* color);
 int
 bit_search_sentinel(Bit_Chain * dat, unsigned char sentinel[16]);
 
+int
+bit_search_sentinel_range(Bit_Chain * dat, unsigned char sentinel[16],
+                          long unsigned int start, long unsigned int end);
+
 void
 bit_write_sentinel(Bit_Chain * dat, unsigned char sentinel[16]);
 
 void
 bit_chain_alloc(Bit_Chain * dat);
 
+int
+bit_chain_reserve(Bit_Chain * dat, long unsigned int n);
+
 void
 bit_print(Bit_Chain * dat, long unsigned int size);
 
@@ -20,12 +20,31 @@
 
 
 #include "classes.h"
+#include "decode.h"
 #include "decode_r2004.h"
+#include "object.h"
 #include "logging.h"
 
 extern unsigned int
 bit_ckr8(unsigned int dx, unsigned char *adr, long n);
 
+/* Return nonzero if the read filter leaves the objects of the class
+ * named dxfname undecoded.
+ */
+static unsigned char
+class_skipped(Dwg_Data *dwg, const char *dxfname)
+{
+  const char **name;
+
+  if (!dwg->read_options || !(dwg->read_options->flags & DWG_OPT_FILTER))
+    return 0;
+  if (dwg->read_options->classes && dxfname)
+    for (name = dwg->read_options->classes; *name; name++)
+      if (!strcmp(*name, dxfname))
+        return 0;
+  return 1;
+}
+
 /* Read R13_R15 Classes Section
  */
 void
@@ -64,14 +83,18 @@ read_R13_R15_section_classes(Bit_Chain *dat, Dwg_Data *dwg)
 
       dwg->dwg_class[idc].number = bit_read_BS(dat);
       dwg->dwg_class[idc].version = bit_read_BS(dat);
-      dwg->dwg_class[idc].appname = bit_read_TV(dat);
-      dwg->dwg_class[idc].cppname = bit_read_TV(dat);
-      dwg->dwg_class[idc].dxfname = bit_read_TV(dat);
+      dwg->dwg_class[idc].appname = dwg_decode_TV(dat, dwg);
+      dwg->dwg_class[idc].cppname = dwg_decode_TV(dat, dwg);
+      dwg->dwg_class[idc].dxfname = dwg_decode_TV(dat, dwg);
       dwg->dwg_class[idc].wasazombie = bit_read_B(dat);
       dwg->dwg_class[idc].item_class_id = bit_read_BS(dat);
 
       if (strcmp((const char *)dwg->dwg_class[idc].dxfname, "LAYOUT") == 0)
         dwg->dwg_ot_layout = dwg->dwg_class[idc].number;
+      dwg->dwg_class[idc].decode =
+        dwg_class_decoder(dat, (const char *)dwg->dwg_class[idc].dxfname);
+      dwg->dwg_class[idc].skip =
+        class_skipped(dwg, (const char *)dwg->dwg_class[idc].dxfname);
 
       dwg->num_classes++;
       /*
@@ -90,13 +113,16 @@ read_R13_R15_section_classes(Bit_Chain *dat, Dwg_Data *dwg)
               + dwg->header.section[1].size - 18;
   dat->bit = 0;
   ckr = bit_read_RS(dat);
-  ckr2 = bit_ckr8(0xc0c1, dat->chain + dwg->header.section[1].address
-                  + 16, dwg->header.section[1].size - 34);
+  ckr2 = ckr;
+  if (!(dwg->opts & DWG_OPT_NO_CRC))
+    ckr2 = bit_ckr8(0xc0c1, dat->chain + dwg->header.section[1].address
+                    + 16, dwg->header.section[1].size - 34);
 
   if (ckr != ckr2)
     {
       printf("section %d crc todo ckr:%x ckr2:%x\n",
               dwg->header.section[1].number, ckr, ckr2);
+      dwg->stats.crc_failures++;
       return -1;
     }
 
@@ -148,9 +174,9 @@ read_2004_section_classes(Bit_Chain* dat, Dwg_Data *dwg)
 
           dwg->dwg_class[idc].number = bit_read_BS(&sec_dat);
           dwg->dwg_class[idc].version = bit_read_BS(&sec_dat);
-          dwg->dwg_class[idc].appname = bit_read_TV(&sec_dat);
-          dwg->dwg_class[idc].cppname = bit_read_TV(&sec_dat);
-          dwg->dwg_class[idc].dxfname = bit_read_TV(&sec_dat);
+          dwg->dwg_class[idc].appname = dwg_decode_TV(&sec_dat, dwg);
+          dwg->dwg_class[idc].cppname = dwg_decode_TV(&sec_dat, dwg);
+          dwg->dwg_class[idc].dxfname = dwg_decode_TV(&sec_dat, dwg);
           dwg->dwg_class[idc].wasazombie = bit_read_B(&sec_dat);
           dwg->dwg_class[idc].item_class_id = bit_read_BS(&sec_dat);
 
@@ -170,6 +196,11 @@ read_2004_section_classes(Bit_Chain* dat, Dwg_Data *dwg)
           if (strcmp((const char *)dwg->dwg_class[idc].dxfname,
               "LAYOUT") == 0)
             dwg->dwg_ot_layout = dwg->dwg_class[idc].number;
+          dwg->dwg_class[idc].decode =
+            dwg_class_decoder(&sec_dat,
+                (const char *)dwg->dwg_class[idc].dxfname);
+          dwg->dwg_class[idc].skip =
+            class_skipped(dwg, (const char *)dwg->dwg_class[idc].dxfname);
 
           dwg->num_classes++;
         } while (sec_dat.byte < (size - 1));
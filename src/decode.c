@@ -22,49 +22,78 @@
 #include "logging.h"
 #include "decode_r13_r15.h"
 #include "decode_r2004.h"
+#include "decode_r2007.h"
+#include "stats.h"
 
 // extern unsigned int
 // bit_ckr8(unsigned int dx, unsigned char *adr, long n);
 
-/* The logging level for the read (decode) path.  */
-static unsigned int loglevel;
-
 #ifdef USE_TRACING
-/* This flag means we have checked the environment variable
-   LIBREDWG_TRACE and set `loglevel' appropriately.  */
-static bool env_var_checked_p;
-
-#define DWG_LOGLEVEL loglevel
+#undef DWG_LOGLEVEL
+#define DWG_LOGLEVEL DWG_DECODE_LOGLEVEL
 #endif  /* USE_TRACING */
 
-#define REFS_PER_REALLOC 100
-
-int read_r2007_meta_data(Bit_Chain *dat, Dwg_Data *dwg);
-
 /*--------------------------------------------------------------------------------
  * Public function definitions
  */
-int
-dwg_decode_data(Bit_Chain * dat, Dwg_Data * dwg)
+
+/* Set up the context of a decode.  The logging level is read from
+ * LIBREDWG_TRACE for each decode, rather than once into a global.
+ */
+void
+dwg_decode_context(Decode_Context *context)
+{
+  memset(context, 0, sizeof(Decode_Context));
+#ifdef USE_TRACING
+  {
+    char *probe = getenv ("LIBREDWG_TRACE");
+
+    if (probe)
+      context->loglevel = atoi (probe);
+  }
+#endif  /* USE_TRACING */
+}
+
+/* Decode the drawing of dat into dwg, by its version.
+ */
+static int
+decode_data(Bit_Chain * dat, Dwg_Data * dwg)
 {
   char version[7];
+
+  dwg_decode_context(&dat->context);
+
   dwg->num_object_refs = 0;
+  dwg->object_ref = 0;
   dwg->num_layers = 0;
   dwg->num_entities = 0;
   dwg->num_objects = 0;
+  dwg->num_alloced_objects = 0;
+  dwg->object = 0;
   dwg->num_classes = 0;
-
-#ifdef USE_TRACING
-  /* Before starting, set the logging level, but only do so once.  */
-  if (! env_var_checked_p)
-    {
-      char *probe = getenv ("LIBREDWG_TRACE");
-
-      if (probe)
-        loglevel = atoi (probe);
-      env_var_checked_p = true;
+  dwg->dwg_class = 0;
+  dwg->num_handle_index = 0;
+  dwg->handle_index = 0;
+  dwg->header.num_sections = 0;
+  dwg->header.section = 0;
+  dwg->header.num_descriptions = 0;
+  dwg->header.section_info = 0;
+  dwg->unknown1.chain = 0;
+  dwg->picture.chain = 0;
+  dwg->object_chain = 0;
+  dwg->object_chain_size = 0;
+  memset(&dwg->header_vars, 0, sizeof(Dwg_Header_Variables));
+
+  dwg->arena = 0;
+  if (dwg->opts & DWG_OPT_ARENA)
+    {
+      dwg->arena = dwg_arena_new();
+      if (!dwg->arena)
+        {
+          LOG_ERROR("Out of memory")
+          return -1;
+        }
     }
-#endif  /* USE_TRACING */
 
   /* Version */
   dat->byte = 0;
@@ -131,6 +160,23 @@ dwg_decode_data(Bit_Chain * dat, Dwg_Data * dwg)
   return -1;
 }
 
+/* Decode the drawing of dat into dwg, keeping the statistics of the load
+ * in dwg->stats.
+ */
+int
+dwg_decode_data(Bit_Chain * dat, Dwg_Data * dwg)
+{
+  double start;
+  int error;
+
+  memset(&dwg->stats, 0, sizeof(Dwg_Load_Stats));
+  start = dwg_stats_clock(dwg);
+  error = decode_data(dat, dwg);
+  dwg->stats.total_time = dwg_stats_clock(dwg) - start;
+  dwg_stats_count_objects(dwg);
+  return error;
+}
+
 int
 decode_R2007(Bit_Chain* dat, Dwg_Data * dwg)
 {
@@ -138,6 +184,7 @@ decode_R2007(Bit_Chain* dat, Dwg_Data * dwg)
   unsigned long int preview_address, security_type, unknown_long,
       dwg_property_address, vba_proj_address, app_info_address;
   unsigned char sig, DwgVer, MaintReleaseVer;
+  double start;
 
   /* 5 bytes of 0x00 */
   dat->byte = 0x06;
@@ -145,8 +192,7 @@ decode_R2007(Bit_Chain* dat, Dwg_Data * dwg)
   for (i = 0; i < 5; i++)
     {
       sig = bit_read_RC(dat);
-      if (loglevel)
-        LOG_TRACE("0x%02X ", sig)
+      LOG_TRACE("0x%02X ", sig)
     }
   LOG_TRACE("\n")
 
@@ -223,7 +269,9 @@ decode_R2007(Bit_Chain* dat, Dwg_Data * dwg)
   LOG_TRACE("Application Info Address: 0x%08X\n",
         (unsigned int) app_info_address)
 
+  start = dwg_stats_clock(dwg);
   read_r2007_meta_data(dat, dwg);
+  dwg->stats.locate_time += dwg_stats_clock(dwg) - start;
   
   LOG_TRACE("\n\n")
 
@@ -244,6 +292,7 @@ decode_R2007(Bit_Chain* dat, Dwg_Data * dwg)
 int
 dwg_decode_entity(Bit_Chain * dat, Dwg_Object_Entity * ent)
 {
+  Dwg_Data *dwg = ent->object->parent;
   unsigned int i;
   unsigned int size;
   int error = 2;
@@ -285,13 +334,14 @@ dwg_decode_entity(Bit_Chain * dat, Dwg_Object_Entity * ent)
         }
       if (ent->extended_size == 0)
         {
-          ent->extended = (char *)malloc(size);
+          ent->extended = (char *)dwg_malloc(dwg, size);
           ent->extended_size = size;
         }
       else
         {
           ent->extended_size += size;
-          ent->extended = (char *)realloc(ent->extended, ent->extended_size);
+          ent->extended = (char *)dwg_realloc(dwg, ent->extended,
+              ent->extended_size - size, ent->extended_size);
         }
       error = bit_read_H(dat, &ent->extended_handle);
       if (error)
@@ -305,7 +355,7 @@ dwg_decode_entity(Bit_Chain * dat, Dwg_Object_Entity * ent)
       ent->picture_size = bit_read_RL(dat);
       if (ent->picture_size < 210210)
         {
-          ent->picture = (char *)malloc(ent->picture_size);
+          ent->picture = (char *)dwg_malloc(dwg, ent->picture_size);
           for (i = 0; i < ent->picture_size; i++)
             ent->picture[i] = bit_read_RC(dat);
         }
@@ -357,14 +407,13 @@ dwg_decode_entity(Bit_Chain * dat, Dwg_Object_Entity * ent)
               if (flags & 0x8000)
                 {
                   unsigned char c1, c2, c3, c4;
-                  char *name=0;
               
                   c1 = bit_read_RC(dat);  // rgb color
                   c2 = bit_read_RC(dat);
                   c3 = bit_read_RC(dat);
                   c4 = bit_read_RC(dat);
               
-                  name = bit_read_TV(dat);
+                  ent->color.name = (char *) dwg_decode_TV(dat, dwg);
                 }
             
               if (flags & 0x4000)
@@ -382,7 +431,7 @@ dwg_decode_entity(Bit_Chain * dat, Dwg_Object_Entity * ent)
         }
     }
   OTHER_VERSIONS
-    bit_read_CMC(dat, &ent->color);
+    dwg_decode_CMC(dat, dwg, &ent->color);
 
   ent->linetype_scale = bit_read_BD(dat);
 
@@ -411,6 +460,7 @@ dwg_decode_entity(Bit_Chain * dat, Dwg_Object_Entity * ent)
 int
 dwg_decode_object(Bit_Chain * dat, Dwg_Object_Object * ord)
 {
+  Dwg_Data *dwg = ord->object->parent;
   unsigned int i;
   unsigned int size;
   int error = 2;
@@ -446,13 +496,14 @@ dwg_decode_object(Bit_Chain * dat, Dwg_Object_Object * ord)
         }
       if (ord->extended_size == 0)
         {
-          ord->extended = (unsigned char *)malloc(size);
+          ord->extended = (unsigned char *)dwg_malloc(dwg, size);
           ord->extended_size = size;
         }
       else
         {
           ord->extended_size += size;
-          ord->extended = (unsigned char *)realloc(ord->extended, ord->extended_size);
+          ord->extended = (unsigned char *)dwg_realloc(dwg, ord->extended,
+              ord->extended_size - size, ord->extended_size);
         }
       error = bit_read_H(dat, &ord->extended_handle);
       if (error)
@@ -481,9 +532,10 @@ Dwg_Object_Ref *
 dwg_decode_handleref(Bit_Chain * dat, Dwg_Object * obj, Dwg_Data* dwg)
 {
   // Welcome to the house of evil code!
-  Dwg_Object_Ref* ref = (Dwg_Object_Ref *) malloc(sizeof(Dwg_Object_Ref));
+  Dwg_Object_Ref* ref;
+  Dwg_Handle handleref;
 
-  if (bit_read_H(dat, &ref->handleref))
+  if (bit_read_H(dat, &handleref))
     {
       if (obj)
         {
@@ -495,10 +547,12 @@ dwg_decode_handleref(Bit_Chain * dat, Dwg_Object * obj, Dwg_Data* dwg)
         {
           LOG_ERROR("Could not read handleref in the header variables section\n")
         }
-      free(ref);
       return 0;
     }
 
+  ref = (Dwg_Object_Ref *) dwg_malloc(dwg, sizeof(Dwg_Object_Ref));
+  ref->handleref = handleref;
+
   //Reserve memory space for object references
   if (dwg->num_object_refs == 0)
     dwg->object_ref = (Dwg_Object_Ref **) malloc(REFS_PER_REALLOC * sizeof(Dwg_Object_Ref*));
@@ -586,20 +640,37 @@ dwg_decode_common_entity_handle_data(Bit_Chain * dat, Dwg_Object * obj)
 
 }
 
-enum RES_BUF_VALUE_TYPE
+/* Read simple text into memory owned by dwg.
+ */
+BITCODE_TV
+dwg_decode_TV(Bit_Chain * dat, Dwg_Data * dwg)
 {
-  VT_INVALID = 0,
-  VT_STRING = 1,
-  VT_POINT3D = 2,
-  VT_REAL = 3,
-  VT_INT16 = 4,
-  VT_INT32 = 5,
-  VT_INT8 = 6,
-  VT_BINARY = 7,
-  VT_HANDLE = 8,
-  VT_OBJECTID = 9,
-  VT_BOOL = 10
-};
+  unsigned int length;
+  unsigned char *chain;
+
+  length = bit_read_BS(dat);
+  chain = (unsigned char *) dwg_malloc(dwg, length + 1);
+  bit_read_text(dat, chain, length);
+
+  return chain;
+}
+
+/* Read a color, as bit_read_CMC does, with its names owned by dwg.
+ */
+void
+dwg_decode_CMC(Bit_Chain * dat, Dwg_Data * dwg, Dwg_Color * color)
+{
+  color->index = bit_read_BS(dat);
+  if (dat->version >= R_2004)
+    {
+      color->rgb = bit_read_BL(dat);
+      color->byte = bit_read_RC(dat);
+      if (color->byte & 1)
+        color->name = (char *) dwg_decode_TV(dat, dwg);
+      if (color->byte & 2)
+        color->book_name = (char *) dwg_decode_TV(dat, dwg);
+    }
+}
 
 enum RES_BUF_VALUE_TYPE
 get_base_value_type(short gc)
@@ -688,25 +759,30 @@ get_base_value_type(short gc)
 }
 
 Dwg_Resbuf*
-dwg_decode_xdata(Bit_Chain * dat, int size)
+dwg_decode_xdata(Bit_Chain * dat, Dwg_Data * dwg, int size)
 {
-  char group_code;
+  short group_code;
   Dwg_Resbuf *rbuf, *root=0, *curr=0;
   unsigned char codepage;
   long unsigned int end_address;
   char hdl[8];
   int i, length;
 
-  static int cnt = 0;
-  cnt++;
-
   end_address = dat->byte + (unsigned long int)size;
 
   while (dat->byte < end_address)
     {
-      rbuf = (Dwg_Resbuf *) malloc(sizeof(Dwg_Resbuf));
+      group_code = bit_read_RS(dat);
+      if (get_base_value_type(group_code) == VT_INVALID)
+        {
+          LOG_ERROR("Invalid group code in xdata: %d!\n", group_code)
+          dat->byte = end_address;
+          return root;
+        }
+
+      rbuf = (Dwg_Resbuf *) dwg_calloc(dwg, 1, sizeof(Dwg_Resbuf));
       rbuf->next = 0;
-      rbuf->type = bit_read_RS(dat);
+      rbuf->type = group_code;
 
       switch (get_base_value_type(rbuf->type))
         {
@@ -715,7 +791,7 @@ dwg_decode_xdata(Bit_Chain * dat, int size)
           codepage = bit_read_RC(dat);
           if (length > 0)
             {
-              rbuf->value.str = (char *)malloc((length + 1) * sizeof(char));
+              rbuf->value.str = (char *)dwg_malloc(dwg, (length + 1) * sizeof(char));
               for (i = 0; i < length; i++)
                 rbuf->value.str[i] = bit_read_RC(dat);
               rbuf->value.str[i] = '\0';
@@ -743,7 +819,7 @@ dwg_decode_xdata(Bit_Chain * dat, int size)
           rbuf->value.chunk.size = bit_read_RC(dat);          
           if (rbuf->value.chunk.size > 0)
             {
-              rbuf->value.chunk.data = (char *)malloc(rbuf->value.chunk.size * sizeof(char));
+              rbuf->value.chunk.data = (char *)dwg_malloc(dwg, rbuf->value.chunk.size * sizeof(char));
               for (i = 0; i < rbuf->value.chunk.size; i++)
                 rbuf->value.chunk.data[i] = bit_read_RC(dat);
             }
@@ -754,10 +830,6 @@ dwg_decode_xdata(Bit_Chain * dat, int size)
              rbuf->value.hdl[i] = bit_read_RC(dat);
           break;
         default:
-          LOG_ERROR("Invalid group code in xdata: %d!\n", rbuf->type)
-          free(rbuf);
-          dat->byte = end_address;
-          return root;
           break;
         }
 
@@ -771,3 +843,28 @@ dwg_decode_xdata(Bit_Chain * dat, int size)
     }
     return root;
 }
+
+/* Release a list of xdata read by dwg_decode_xdata.
+ */
+void
+dwg_free_xdata(Dwg_Resbuf *rbuf)
+{
+  Dwg_Resbuf *next;
+
+  for (; rbuf; rbuf = next)
+    {
+      next = rbuf->next;
+      switch (get_base_value_type(rbuf->type))
+        {
+        case VT_STRING:
+          free(rbuf->value.str);
+          break;
+        case VT_BINARY:
+          free(rbuf->value.chunk.data);
+          break;
+        default:
+          break;
+        }
+      free(rbuf);
+    }
+}
@@ -20,9 +20,6 @@
 #ifndef DECODE_H
 #define DECODE_H
 
-#ifndef _DWG_OBJECT_H_
-#define _DWG_OBJECT_H_
-
 #include "config.h"
 #include <stdbool.h>
 #include <stdio.h>
@@ -31,10 +28,14 @@
 #include <assert.h>
 
 #include "common.h"
+#include "arena.h"
 #include "bits.h"
 #include "dwg.h"
 #include "print.h"
 
+/* The object reference vector grows by this many entries at a time.  */
+#define REFS_PER_REALLOC 100
+
 /*--------------------------------------------------------------------------------
  * Welcome to the dark side of the moon...
  * MACROS
@@ -75,7 +76,9 @@
 #define FIELD_RL(name) FIELD(name, RL);
 #define FIELD_MC(name) FIELD(name, MC);
 #define FIELD_MS(name) FIELD(name, MS);
-#define FIELD_TV(name) FIELD(name, TV);
+#define FIELD_TV(name)\
+  _obj->name = dwg_decode_TV(dat, dwg);\
+  LOG_TRACE(#name ": " FORMAT_TV "\n", _obj->name)
 #define FIELD_T FIELD_TV /*TODO: implement version dependant string fields */
 #define FIELD_BT(name) FIELD(name, BT);
 #define FIELD_4BITS(name) _obj->name = bit_read_4BITS(dat);
@@ -89,7 +92,7 @@
 #define FIELD_3BD(name) FIELD(name.x, BD); FIELD(name.y, BD); FIELD(name.z, BD);
 #define FIELD_3DPOINT(name) FIELD_3BD(name)
 #define FIELD_CMC(name)\
-    bit_read_CMC(dat, &_obj->name);\
+    dwg_decode_CMC(dat, dwg, &_obj->name);\
     LOG_TRACE(#name ": index %d\n", _obj->name.index)
 
 //FIELD_VECTOR_N(name, type, size):
@@ -98,7 +101,7 @@
 #define FIELD_VECTOR_N(name, type, size)\
   if (size>0)\
     {\
-      _obj->name = (BITCODE_##type*) malloc(size * sizeof(BITCODE_##type));\
+      _obj->name = (BITCODE_##type*) dwg_malloc(dwg, size * sizeof(BITCODE_##type));\
       for (vcount=0; vcount< size; vcount++)\
         {\
           _obj->name[vcount] = bit_read_##type(dat);\
@@ -108,15 +111,28 @@
 
 #define FIELD_VECTOR(name, type, size) FIELD_VECTOR_N(name, type, _obj->size)
 
+//FIELD_VECTOR_T(name, size):
+// same for a vector of strings, which are owned by dwg.
+#define FIELD_VECTOR_T(name, size)\
+  if (_obj->size>0)\
+    {\
+      _obj->name = (BITCODE_TV*) dwg_malloc(dwg, _obj->size * sizeof(BITCODE_TV));\
+      for (vcount=0; vcount< _obj->size; vcount++)\
+        {\
+          _obj->name[vcount] = dwg_decode_TV(dat, dwg);\
+          LOG_TRACE(#name "[%d]: " FORMAT_TV "\n", vcount, _obj->name[vcount])\
+        }\
+    }
+
 #define FIELD_2RD_VECTOR(name, size)\
-  _obj->name = (BITCODE_2RD *) malloc(_obj->size * sizeof(BITCODE_2RD));\
+  _obj->name = (BITCODE_2RD *) dwg_malloc(dwg, _obj->size * sizeof(BITCODE_2RD));\
   for (vcount=0; vcount< _obj->size; vcount++)\
     {\
       FIELD_2RD(name[vcount]);\
     }
 
 #define FIELD_2DD_VECTOR(name, size)\
-  _obj->name = (BITCODE_2RD *) malloc(_obj->size * sizeof(BITCODE_2RD));\
+  _obj->name = (BITCODE_2RD *) dwg_malloc(dwg, _obj->size * sizeof(BITCODE_2RD));\
   FIELD_2RD(name[0]);\
   for (vcount = 1; vcount < _obj->size; vcount++)\
     {\
@@ -124,14 +140,14 @@
     }
 
 #define FIELD_3DPOINT_VECTOR(name, size)\
-  _obj->name = (BITCODE_3DPOINT *) malloc(_obj->size * sizeof(BITCODE_3DPOINT));\
+  _obj->name = (BITCODE_3DPOINT *) dwg_malloc(dwg, _obj->size * sizeof(BITCODE_3DPOINT));\
   for (vcount=0; vcount< _obj->size; vcount++)\
     {\
       FIELD_3DPOINT(name[vcount]);\
     }
 
 #define HANDLE_VECTOR_N(name, size, code)\
-  FIELD_VALUE(name) = (BITCODE_H*) malloc(sizeof(BITCODE_H) * size);\
+  FIELD_VALUE(name) = (BITCODE_H*) dwg_malloc(dwg, sizeof(BITCODE_H) * size);\
   for (vcount=0; vcount<size; vcount++)\
     {\
       FIELD_HANDLE(name[vcount], code);\
@@ -140,17 +156,17 @@
 #define HANDLE_VECTOR(name, sizefield, code) HANDLE_VECTOR_N(name, FIELD_VALUE(sizefield), code)
 
 #define FIELD_XDATA(name, size)\
-  _obj->name = dwg_decode_xdata(dat, _obj->size)
+  _obj->name = dwg_decode_xdata(dat, dwg, _obj->size)
 
 #define REACTORS(code)\
-  FIELD_VALUE(reactors) = (BITCODE_H*) malloc(sizeof(BITCODE_H) * obj->tio.object->num_reactors);\
+  FIELD_VALUE(reactors) = (BITCODE_H*) dwg_malloc(dwg, sizeof(BITCODE_H) * obj->tio.object->num_reactors);\
   for (vcount=0; vcount<obj->tio.object->num_reactors; vcount++)\
     {\
       FIELD_HANDLE(reactors[vcount], code);\
     }
 
 #define ENT_REACTORS(code)\
-  FIELD_VALUE(reactors) = (BITCODE_H*) malloc(sizeof(BITCODE_H) * obj->tio.entity->num_reactors);\
+  FIELD_VALUE(reactors) = (BITCODE_H*) dwg_malloc(dwg, sizeof(BITCODE_H) * obj->tio.entity->num_reactors);\
   for (vcount=0; vcount<obj->tio.entity->num_reactors; vcount++)\
     {\
       FIELD_HANDLE(reactors[vcount], code);\
@@ -183,19 +199,19 @@
     }
 
 #define REPEAT_N(times, name, type) \
-  _obj->name = (type *) malloc(times * sizeof(type));\
+  _obj->name = (type *) dwg_calloc(dwg, times, sizeof(type));\
   for (rcount=0; rcount<times; rcount++)
 
 #define REPEAT(times, name, type) \
-  _obj->name = (type *) malloc(_obj->times * sizeof(type));\
+  _obj->name = (type *) dwg_calloc(dwg, _obj->times, sizeof(type));\
   for (rcount=0; rcount<_obj->times; rcount++)
 
 #define REPEAT2(times, name, type) \
-  _obj->name = (type *) malloc(_obj->times * sizeof(type));\
+  _obj->name = (type *) dwg_calloc(dwg, _obj->times, sizeof(type));\
   for (rcount2=0; rcount2<_obj->times; rcount2++)
 
 #define REPEAT3(times, name, type) \
-  _obj->name = (type *) malloc(_obj->times * sizeof(type));\
+  _obj->name = (type *) dwg_calloc(dwg, _obj->times, sizeof(type));\
   for (rcount3=0; rcount3<_obj->times; rcount3++)
 
 //TODO unify REPEAT macros!
@@ -203,9 +219,15 @@
 #define COMMON_ENTITY_HANDLE_DATA \
   dwg_decode_common_entity_handle_data(dat, obj)
 
+/* Name of the decoder of the objects of type token.  With tracing, the
+   specs are compiled a second time, with logging, under other names.  */
+#ifndef DWG_DECODER
+#define DWG_DECODER(token) dwg_decode_##token
+#endif
+
 #define DWG_ENTITY(token) \
 void \
- dwg_decode_##token (Bit_Chain * dat, Dwg_Object * obj)\
+ DWG_DECODER(token) (Bit_Chain * dat, Dwg_Object * obj)\
 {\
   int vcount, rcount, rcount2, rcount3;\
   Dwg_Entity_##token *ent, *_obj;\
@@ -213,8 +235,8 @@ void \
   LOG_INFO("Entity " #token ":\n")\
   dwg->num_entities++;\
   obj->supertype = DWG_SUPERTYPE_ENTITY;\
-  obj->tio.entity = (Dwg_Object_Entity*)malloc (sizeof (Dwg_Object_Entity));	\
-  obj->tio.entity->tio.token = (Dwg_Entity_##token *)calloc (sizeof (Dwg_Entity_##token), 1); \
+  obj->tio.entity = (Dwg_Object_Entity*)dwg_calloc (dwg, sizeof (Dwg_Object_Entity), 1);	\
+  obj->tio.entity->tio.token = (Dwg_Entity_##token *)dwg_calloc (dwg, sizeof (Dwg_Entity_##token), 1); \
   ent = obj->tio.entity->tio.token;\
   _obj=ent;\
   obj->tio.entity->object = obj;\
@@ -226,14 +248,14 @@ void \
 
 #define DWG_ENTITY_END }
 
-#define DWG_OBJECT(token) void  dwg_decode_ ## token (Bit_Chain * dat, Dwg_Object * obj) {\
+#define DWG_OBJECT(token) void  DWG_DECODER(token) (Bit_Chain * dat, Dwg_Object * obj) {\
   int vcount, rcount, rcount2, rcount3;\
   Dwg_Object_##token *_obj;\
   Dwg_Data* dwg = obj->parent;\
   LOG_INFO("Object " #token ":\n")\
   obj->supertype = DWG_SUPERTYPE_OBJECT;\
-  obj->tio.object = (Dwg_Object_Object*)malloc (sizeof (Dwg_Object_Object));	\
-  obj->tio.object->tio.token = (Dwg_Object_##token * ) calloc (sizeof (Dwg_Object_##token), 1); \
+  obj->tio.object = (Dwg_Object_Object*)dwg_calloc (dwg, sizeof (Dwg_Object_Object), 1);	\
+  obj->tio.object->tio.token = (Dwg_Object_##token * ) dwg_calloc (dwg, sizeof (Dwg_Object_##token), 1); \
   obj->tio.object->object = obj;\
   if (dwg_decode_object (dat, obj->tio.object)) return;\
   _obj = obj->tio.object->tio.token;\
@@ -244,6 +266,9 @@ void \
 
 #define DWG_OBJECT_END }
 
+void
+dwg_decode_context(Decode_Context *context);
+
 int
 dwg_decode_data(Bit_Chain * bit_chain, Dwg_Data * dwg_data);
 
@@ -263,11 +288,13 @@ dwg_decode_handleref_with_code(Bit_Chain * dat, Dwg_Object * obj,
 void
 dwg_decode_common_entity_handle_data(Bit_Chain * dat, Dwg_Object * obj);
 
-Dwg_Resbuf*
-dwg_decode_xdata(Bit_Chain * dat, int size);
+BITCODE_TV
+dwg_decode_TV(Bit_Chain * dat, Dwg_Data * dwg);
 
-#endif
+void
+dwg_decode_CMC(Bit_Chain * dat, Dwg_Data * dwg, Dwg_Color * color);
 
-#undef IS_DECODER
+Dwg_Resbuf*
+dwg_decode_xdata(Bit_Chain * dat, Dwg_Data * dwg, int size);
 
 #endif
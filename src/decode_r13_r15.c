@@ -18,6 +18,7 @@
  * modified by Till Heuschmann
  */
 
+#include "arena.h"
 #include "classes.h"
 #include "decode_r13_r15.h"
 #include "handle.h"
@@ -25,7 +26,42 @@
 #include "logging.h"
 #include "resolve_pointers.h"
 #include "section_locate.h"
+#include "stats.h"
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+/* If the file is mapped (DWG_OPT_MMAP), tell the kernel which ranges of
+ * the mapping the section locator points us to.
+ */
+static void
+advise_sections(Bit_Chain *dat, Dwg_Data *dwg)
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MADVISE)
+  long unsigned int page = sysconf(_SC_PAGESIZE);
+  long unsigned int start, end;
+  unsigned int i;
+
+  if (!(dwg->opts & DWG_OPT_MMAP))
+    return;
+
+  for (i = 0; i < dwg->header.num_sections; i++)
+    {
+      start = dwg->header.section[i].address;
+      end = start + dwg->header.section[i].size;
+      if (start >= dat->size || end <= start)
+        continue;
+      if (end > dat->size)
+        end = dat->size;
+      start -= start % page;
+      madvise(dat->chain + start, end - start, MADV_WILLNEED);
+    }
+#endif
+}
 
 /* Read Unknown Section 
  */
@@ -43,7 +79,7 @@ read_section_unknown(Bit_Chain *dat, Dwg_Data *dwg)
       dat->byte = dwg->header.section[5].address;
       dwg->unknown1.size = DWG_UNKNOWN1_SIZE;
       dwg->unknown1.byte = dwg->unknown1.bit = 0;
-      dwg->unknown1.chain = (unsigned char*) malloc(dwg->unknown1.size);
+      dwg->unknown1.chain = (unsigned char*) dwg_malloc(dwg, dwg->unknown1.size);
       memcpy(dwg->unknown1.chain, &dat->chain[dat->byte], 
              dwg->unknown1.size);
 
@@ -66,13 +102,14 @@ read_section_picture(Bit_Chain *dat, Dwg_Data *dwg)
       LOG_TRACE("\n PICTURE: %8X\n",
                 (unsigned int) start_address - 16)
 
-      if (bit_search_sentinel(dat, dwg_sentinel(DWG_SENTINEL_PICTURE_END)))
+      if (bit_search_sentinel_range(dat,
+          dwg_sentinel(DWG_SENTINEL_PICTURE_END), start_address, dat->size))
         {
           LOG_TRACE(" PICTURE (end): %8X\n",
                     (unsigned int) dat->byte)
 
           dwg->picture.size = (dat->byte - 16) - start_address;
-          dwg->picture.chain = (unsigned char *) malloc(dwg->picture.size);
+          dwg->picture.chain = (unsigned char *) dwg_malloc(dwg, dwg->picture.size);
           memcpy(dwg->picture.chain, &dat->chain[start_address],
                  dwg->picture.size);
         }
@@ -86,8 +123,14 @@ read_section_picture(Bit_Chain *dat, Dwg_Data *dwg)
 void
 read_section_second_header(Bit_Chain *dat, Dwg_Data *dwg)
 {
-  if (bit_search_sentinel(dat, 
-      dwg_sentinel(DWG_SENTINEL_SECOND_HEADER_BEGIN)))
+  unsigned long int start = 0;
+
+  /* The second header follows the object map */
+  if (dwg->header.num_sections > 2)
+    start = dwg->header.section[2].address + dwg->header.section[2].size;
+
+  if (bit_search_sentinel_range(dat,
+      dwg_sentinel(DWG_SENTINEL_SECOND_HEADER_BEGIN), start, dat->size))
     {
       long unsigned int ckr;
       long unsigned int pvz;
@@ -189,8 +232,8 @@ read_section_second_header(Bit_Chain *dat, Dwg_Data *dwg)
        }
        */
 
-      if (bit_search_sentinel(dat, 
-          dwg_sentinel(DWG_SENTINEL_SECOND_HEADER_END)))
+      if (bit_search_sentinel_range(dat,
+          dwg_sentinel(DWG_SENTINEL_SECOND_HEADER_END), dat->byte, dat->size))
         LOG_INFO(" Second Header (end): %8X\n",
                  (unsigned int) dat->byte)
     }
@@ -228,6 +271,7 @@ decode_R13_R15(Bit_Chain *dat, Dwg_Data *dwg)
   unsigned char sig;
   long unsigned int pvz;
   unsigned int i;
+  double start, objects_time;
 
   // Still unknown values: 6 'zeroes' and a 'one'
   dat->byte = 0x06;
@@ -256,7 +300,10 @@ decode_R13_R15(Bit_Chain *dat, Dwg_Data *dwg)
 
   /* Section Locator Records */
   dat->byte = 0x15;
+  start = dwg_stats_clock(dwg);
   read_R13_R15_section_locate(dat, dwg);
+  advise_sections(dat, dwg);
+  dwg->stats.locate_time += dwg_stats_clock(dwg) - start;
 
   /* Unknown section 1*/
   read_section_unknown(dat, dwg);
@@ -265,13 +312,21 @@ decode_R13_R15(Bit_Chain *dat, Dwg_Data *dwg)
   read_section_picture(dat, dwg);
 
   /* Header Variables */
+  start = dwg_stats_clock(dwg);
   read_R13_R15_section_header(dat, dwg);
+  dwg->stats.header_time += dwg_stats_clock(dwg) - start;
 
   /* Classes */
+  start = dwg_stats_clock(dwg);
   read_R13_R15_section_classes(dat, dwg);
+  dwg->stats.classes_time += dwg_stats_clock(dwg) - start;
 
-  /* Object-map */
+  /* Object-map, less the objects decoded as it is read */
+  start = dwg_stats_clock(dwg);
+  objects_time = dwg->stats.objects_time;
   read_R13_R15_section_object_map(dat, dwg);
+  dwg->stats.object_map_time += dwg_stats_clock(dwg) - start
+    - (dwg->stats.objects_time - objects_time);
 
   /* Second header */
   read_section_second_header(dat, dwg);
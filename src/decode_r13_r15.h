@@ -18,8 +18,8 @@
  * modified by Till Heuschmann
  */
 
-#ifndef _DWG_OBJECT_H_
-#define _DWG_OBJECT_H_
+#ifndef DECODE_R13_R15_H
+#define DECODE_R13_R15_H
 
 #include "config.h"
 #include <stdbool.h>
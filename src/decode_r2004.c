@@ -28,15 +28,13 @@
 #include "logging.h"
 #include "resolve_pointers.h"
 #include "section_locate.h"
+#include "stats.h"
+#include "threads.h"
 
-static unsigned int loglevel;
-
-#define DWG_LOGLEVEL loglevel
-
-/* Forward Declaration
- */
-int
-read_literal_length(Bit_Chain* dat, unsigned char *opcode);
+#ifdef USE_TRACING
+#undef DWG_LOGLEVEL
+#define DWG_LOGLEVEL DWG_DECODE_LOGLEVEL
+#endif
 
 /* Encrypted Section Header */
 typedef union _encrypted_section_header
@@ -56,159 +54,208 @@ typedef union _encrypted_section_header
   } fields;
 } encrypted_section_header;
 
-/* R2004 Literal Length
+/* R2004 compressed data is byte aligned, so it is read through a
+ * plain pointer rather than bit_read_RC.  The readers below are given
+ * the end of the data, and return 0 when they would run past it.
  */
-int
-read_literal_length(Bit_Chain* dat, unsigned char *opcode)
+
+/* Read the rest of a long length, after its first (0) byte: 0xFF for
+ * every further 0 byte, plus the first nonzero byte.
+ */
+static const unsigned char *
+read_long_length(const unsigned char *src, const unsigned char *end,
+                 unsigned long int *length)
 {
-  int total = 0;
-  unsigned char byte = bit_read_RC(dat);
+  unsigned long int total = 0;
 
+  while (src < end && *src == 0)
+    {
+      total += 0xFF;
+      src++;
+    }
+  if (src == end)
+    return 0;
+  *length = total + *src++;
+  return src;
+}
+
+/* R2004 Literal Length, or the opcode of the next match when byte is
+ * one (with a length of 0).
+ */
+static const unsigned char *
+read_literal_length(const unsigned char *src, const unsigned char *end,
+                    unsigned char byte, unsigned long int *length,
+                    unsigned char *opcode)
+{
   *opcode = 0x00;
+  *length = 0;
 
   if (byte >= 0x01 && byte <= 0x0F)
-    return byte + 3;
+    *length = byte + 3;
   else if (byte == 0)
     {
-      total = 0x0F;
-      while ((byte = bit_read_RC(dat)) == 0x00)
-        {
-          total += 0xFF;
-        }
-      return total + byte + 3;
+      src = read_long_length(src, end, length);
+      *length += 0x0F + 3;
     }
-  else if (byte & 0xF0)
+  else
     *opcode = byte;
 
-  return 0;
+  return src;
 }
 
-/* R2004 Long Compression Offset
+/* R2004 Long Compression Offset, after its first byte
  */
-int
-read_long_compression_offset(Bit_Chain* dat)
+static const unsigned char *
+read_long_compression_offset(const unsigned char *src,
+                             const unsigned char *end, unsigned char byte,
+                             unsigned long int *offset)
 {
-  int total = 0;
-  unsigned char byte = bit_read_RC(dat);
-  if (byte == 0)
+  if (byte)
     {
-      total = 0xFF;
-      while ((byte = bit_read_RC(dat)) == 0x00)
-        total += 0xFF;
-	}
-  return total + byte;
+      *offset = byte;
+      return src;
+    }
+  src = read_long_length(src, end, offset);
+  *offset += 0xFF;
+  return src;
 }
 
-/* R2004 Two Byte Offset
+/* Copy a match of length bytes from offset + 1 bytes back.  Matches
+ * may overlap their own output: the source then repeats with a period
+ * of offset + 1, and the copy goes in chunks doubling from that size,
+ * each reading only bytes already written.
  */
-int
-read_two_byte_offset(Bit_Chain* dat, int* lit_length)
+static inline void
+copy_match(unsigned char *dst, unsigned long int offset,
+           unsigned long int length)
 {
-  int offset;
-  unsigned char firstByte = bit_read_RC(dat);
-  unsigned char secondByte = bit_read_RC(dat);
-  offset = (firstByte >> 2) | (secondByte << 6);
-  *lit_length = (firstByte & 0x03);
-  return offset;
+  const unsigned char *from = dst - offset - 1;
+  unsigned long int chunk;
+
+  while (length)
+    {
+      chunk = dst - from;
+      if (chunk > length)
+        chunk = length;
+      memcpy(dst, from, chunk);
+      dst += chunk;
+      length -= chunk;
+    }
 }
 
-/* Decompresses a system section of a 2004 DWG flie
+/* Decompresses a system section of a 2004 DWG file: comp_data_size
+ * bytes at dat, into decomp of decomp_data_size bytes.  Returns 1 if
+ * the data is corrupted, leaving decomp partly filled.
  */
 int
 decompress_R2004_section(Bit_Chain* dat, char *decomp,
+                         unsigned long int decomp_data_size,
                          unsigned long int comp_data_size)
 {
-  int lit_length, i;
-  int comp_offset, comp_bytes;
-  unsigned char opcode1 = 0, opcode2;
-  int32_t start_byte = dat->byte;
-  char *src, *dst = decomp;
+  const unsigned char *src, *start, *end;
+  unsigned char *dst = (unsigned char *) decomp;
+  unsigned char *dst_end = dst + decomp_data_size;
+  unsigned long int lit_length, comp_offset, comp_bytes;
+  unsigned char opcode1, opcode2;
 
-  // length of the first sequence of uncompressed or literal data.
-  lit_length = read_literal_length(dat, &opcode1);
+  if (dat->byte >= dat->size)
+    {
+      LOG_ERROR("Compressed section past the end of the file\n")
+      return 1;
+    }
+  start = src = dat->chain + dat->byte;
+  end = dat->chain + dat->size;
 
-  for (i = 0; i < lit_length; ++i)
-    *dst++ = bit_read_RC(dat);
+  // length of the first sequence of uncompressed or literal data.
+  src = read_literal_length(src + 1, end, *src, &lit_length, &opcode1);
 
-  opcode1 = 0x00;
-  while (dat->byte - start_byte < comp_data_size)
+  for (;;)
     {
+      // copy "literal data"
+      if (!src || lit_length > (unsigned long int) (end - src)
+          || lit_length > (unsigned long int) (dst_end - dst))
+        goto corrupted;
+      memcpy(dst, src, lit_length);
+      src += lit_length;
+      dst += lit_length;
+
+      if ((unsigned long int) (src - start) >= comp_data_size)
+        break;
       if (opcode1 == 0x00)
-        opcode1 = bit_read_RC(dat);
-
-      if (opcode1 >= 0x40)
         {
-          comp_bytes = ((opcode1 & 0xF0) >> 4) - 1;
-          opcode2 = bit_read_RC(dat);
-          comp_offset = (opcode2 << 2) | ((opcode1 & 0x0C) >> 2);
-
-          if (opcode1 & 0x03)
-            {
-              lit_length = (opcode1 & 0x03);
-              opcode1  = 0x00;
-            }
-          else
-            lit_length = read_literal_length(dat, &opcode1);
+          if (src == end)
+            goto corrupted;
+          opcode1 = *src++;
         }
-      else if (opcode1 >= 0x21 && opcode1 <= 0x3F)
-        {
-          comp_bytes  = opcode1 - 0x1E;
-          comp_offset = read_two_byte_offset(dat, &lit_length);
 
-          if (lit_length != 0)
-            opcode1 = 0x00;
-          else
-            lit_length = read_literal_length(dat, &opcode1);
-        }
-      else if (opcode1 == 0x20)
+      /* Every match takes at least two more bytes: the rest of the
+         opcode and a literal length or the next opcode.  */
+      if (end - src < 2)
         {
-          comp_bytes  = read_long_compression_offset(dat) + 0x21;
-          comp_offset = read_two_byte_offset(dat, &lit_length);
-
-          if (lit_length != 0)
-            opcode1 = 0x00;
-          else
-            lit_length = read_literal_length(dat, &opcode1);
+          if (opcode1 == 0x11)
+            break;
+          goto corrupted;
         }
-      else if (opcode1 >= 0x12 && opcode1 <= 0x1F)
-        {
-          comp_bytes  = (opcode1 & 0x0F) + 2;
-          comp_offset = read_two_byte_offset(dat, &lit_length) + 0x3FFF;
 
-          if (lit_length != 0)
-            opcode1 = 0x00;
-          else
-            lit_length = read_literal_length(dat, &opcode1);
+      if (opcode1 >= 0x40)
+        {
+          comp_bytes = ((opcode1 & 0xF0) >> 4) - 1;
+          opcode2 = *src++;
+          comp_offset = (opcode2 << 2) | ((opcode1 & 0x0C) >> 2);
+          lit_length = opcode1 & 0x03;
         }
-      else if (opcode1 == 0x10)
+      else if (opcode1 >= 0x10 && opcode1 != 0x11)
         {
-          comp_bytes  = read_long_compression_offset(dat) + 9;
-          comp_offset = read_two_byte_offset(dat, &lit_length) + 0x3FFF;
-
-          if (lit_length != 0)
-            opcode1 = 0x00;
+          if (opcode1 >= 0x21)
+            comp_bytes = opcode1 - 0x1E;
+          else if (opcode1 == 0x20)
+            {
+              src = read_long_compression_offset(src + 1, end, *src,
+                                                 &comp_bytes);
+              comp_bytes += 0x21;
+            }
+          else if (opcode1 >= 0x12)
+            comp_bytes = (opcode1 & 0x0F) + 2;
           else
-            lit_length = read_literal_length(dat, &opcode1);
+            {
+              src = read_long_compression_offset(src + 1, end, *src,
+                                                 &comp_bytes);
+              comp_bytes += 9;
+            }
+          // two byte offset
+          if (!src || end - src < 2)
+            goto corrupted;
+          comp_offset = (src[0] >> 2) | (src[1] << 6);
+          lit_length = src[0] & 0x03;
+          src += 2;
+          if (opcode1 < 0x20)
+            comp_offset += 0x3FFF;
         }
       else if (opcode1 == 0x11)
           break;     // Terminates the input stream, everything is ok!
       else
-          return 1;  // error in input stream
+          goto corrupted;
 
-      //LOG_TRACE("got compressed data %d\n",comp_bytes)
-      // copy "compressed data"
-      src = dst - comp_offset - 1;
-      assert(src > decomp);
-      for (i = 0; i < comp_bytes; ++i)
-        *dst++ = *src++;
+      opcode1 = 0x00;
+      if (!lit_length && src < end)
+        src = read_literal_length(src + 1, end, *src, &lit_length, &opcode1);
 
-      // copy "literal data"
-      //LOG_TRACE("got literal data %d\n",lit_length)
-      for (i = 0; i < lit_length; ++i)
-        *dst++ = bit_read_RC(dat);
+      // copy "compressed data"
+      if (comp_offset >= (unsigned long int) (dst - (unsigned char *) decomp)
+          || comp_bytes > (unsigned long int) (dst_end - dst))
+        goto corrupted;
+      copy_match(dst, comp_offset, comp_bytes);
+      dst += comp_bytes;
     }
 
+  dat->byte = src - dat->chain;
+  dat->bit = 0;
   return 0;  // Success
+
+ corrupted:
+  LOG_ERROR("Corrupted compressed section at %lu\n",
+            (long unsigned int) (src ? src - dat->chain : dat->byte))
+  return 1;
 }
 
 Dwg_Section*
@@ -243,7 +290,8 @@ read_R2004_section_info(Bit_Chain* dat, Dwg_Data *dwg,
   if (decomp == 0)
     return;   // No memory
 
-  decompress_R2004_section(dat, decomp, comp_data_size);
+  decompress_R2004_section(dat, decomp, decomp_data_size, comp_data_size);
+  dwg->stats.bytes_decompressed += decomp_data_size;
 
   memcpy(&dwg->header.num_descriptions, decomp, 4);
   dwg->header.section_info = (Dwg_Section_Info*)
@@ -323,42 +371,41 @@ read_R2004_section_info(Bit_Chain* dat, Dwg_Data *dwg,
 }
 
 
-int
-read_2004_compressed_section(Bit_Chain* dat, Dwg_Data *dwg,
-                            Bit_Chain* sec_dat,
-                            long unsigned int section_type)
+/* The pages of a compressed section, decompressed each into its own
+ * max_decomp_size slot of decomp.
+ */
+typedef struct _section_pages
 {
-  int32_t address, sec_mask;
-  int32_t max_decomp_size;
-  Dwg_Section_Info *info = 0;
-  encrypted_section_header es;
+  Bit_Chain dat;
+  Dwg_Section_Info *info;
   char *decomp;
-  int i, j;
+} Section_Pages;
 
-  for (i = 0; i < dwg->header.num_descriptions && info == 0; ++i)
-    if (dwg->header.section_info[i].type == section_type)
-      info = &dwg->header.section_info[i];
-
-  if (info == 0)
-    return 1;   // Failed to find section
-
-  max_decomp_size = info->num_sections * info->max_decomp_size;
-
-  decomp = (char *)malloc(max_decomp_size * sizeof(char));
-  if (decomp == 0)
-    return 2;   // No memory
+/* Decrypt the header of page i and decompress the page.  Pages share
+ * nothing but the (read only) file data, so this is run on several
+ * threads with DWG_OPT_THREADS.
+ */
+static void
+read_2004_section_page(void *data, unsigned int i)
+{
+  Section_Pages *pages = (Section_Pages *) data;
+  Dwg_Section_Info *info = pages->info;
+  Bit_Chain page_dat = pages->dat;
+  Bit_Chain *dat = &page_dat;
+  encrypted_section_header es;
+  int32_t address, sec_mask;
+  int j;
 
-  for (i = 0; i < info->num_sections; ++i)
-    {
-      address = info->sections[i]->address;
-      dat->byte = address;
+  address = info->sections[i]->address;
+  dat->byte = address;
+  dat->bit = 0;
 
-      for (j = 0; j < 0x20; j++)
-        es.char_data[j] = bit_read_RC(dat);
+  for (j = 0; j < 0x20; j++)
+    es.char_data[j] = bit_read_RC(dat);
 
-      sec_mask = 0x4164536b ^ address;
-      for (j = 0; j < 8; ++j)
-        es.long_data[j] ^= sec_mask;
+  sec_mask = 0x4164536b ^ address;
+  for (j = 0; j < 8; ++j)
+    es.long_data[j] ^= sec_mask;
 
   LOG_INFO("\n=== Section (Class) ===\n")
   LOG_INFO("Section Tag (should be 0x4163043b): %x\n",
@@ -378,15 +425,49 @@ read_2004_compressed_section(Bit_Chain* dat, Dwg_Data *dwg,
   LOG_INFO("Checksum2:        %x\n\n",
         (unsigned int) es.fields.checksum_2)
 
-      decompress_R2004_section(dat, &decomp[i * info->max_decomp_size],
-        es.fields.data_size);
-    }
+  decompress_R2004_section(dat, &pages->decomp[i * info->max_decomp_size],
+    info->max_decomp_size, es.fields.data_size);
+}
+
+int
+read_2004_compressed_section(Bit_Chain* dat, Dwg_Data *dwg,
+                            Bit_Chain* sec_dat,
+                            long unsigned int section_type)
+{
+  int32_t max_decomp_size;
+  Dwg_Section_Info *info = 0;
+  Section_Pages pages;
+  char *decomp;
+  int i;
+
+  for (i = 0; i < dwg->header.num_descriptions && info == 0; ++i)
+    if (dwg->header.section_info[i].type == section_type)
+      info = &dwg->header.section_info[i];
+
+  if (info == 0)
+    return 1;   // Failed to find section
+
+  max_decomp_size = info->num_sections * info->max_decomp_size;
+
+  decomp = (char *)malloc(max_decomp_size * sizeof(char));
+  if (decomp == 0)
+    return 2;   // No memory
+
+  pages.dat = *dat;
+  pages.info = info;
+  pages.decomp = decomp;
+  if (dwg_run_tasks(read_2004_section_page, &pages, info->num_sections,
+                    dwg_num_threads(dwg)))
+    for (i = 0; i < info->num_sections; ++i)
+      read_2004_section_page(&pages, i);
+  dwg->stats.bytes_decompressed += max_decomp_size;
 
   sec_dat->bit     = 0;
   sec_dat->byte    = 0;
   sec_dat->chain   = (unsigned char *)decomp;
   sec_dat->size    = max_decomp_size;
   sec_dat->version = dat->version;
+  sec_dat->context = dat->context;
 
   return 0;
 }
@@ -451,6 +532,7 @@ decode_R2004(Bit_Chain* dat, Dwg_Data * dwg)
   int32_t preview_address, security_type, unknown_long,
           dwg_property_address, vba_proj_address;
   unsigned char sig, dwg_ver, maint_release_ver;
+  double start, objects_time;
 
   //6 bytes of 0x00
   dat->byte = 0x06;
@@ -529,10 +611,12 @@ decode_R2004(Bit_Chain* dat, Dwg_Data * dwg)
   for (i = 0; i < 0x54; i++)
     {
       sig = bit_read_RC(dat);
-      if (sig != 0 && loglevel)
-        LOG_ERROR(
-            "Warning: Byte should be zero! But a value=%x was read instead.\n",
-            sig)
+      if (sig != 0)
+        {
+          LOG_ERROR(
+              "Warning: Byte should be zero! But a value=%x was read instead.\n",
+              sig)
+        }
     }
 
   dat->byte = 0x80;
@@ -543,7 +627,7 @@ decode_R2004(Bit_Chain* dat, Dwg_Data * dwg)
       _2004_header_data.encrypted_data[i] = bit_read_RC(dat) ^ (rseed >> 0x10);
     }
 
-  if (loglevel)
+  if (DWG_LOGLEVEL >= DWG_LOGLEVEL_TRACE)
     {
       LOG_TRACE("\n#### 2004 File Header Data fields ####\n")
       LOG_TRACE("File ID string (must be AcFssFcAJMB): ");
@@ -604,6 +688,7 @@ decode_R2004(Bit_Chain* dat, Dwg_Data * dwg)
   /*-------------------------------------------------------------------------
    * Section Map
    */
+  start = dwg_stats_clock(dwg);
   dat->byte = _2004_header_data.fields.section_map_address + 0x100;
 
   LOG_TRACE("\n\nRaw system section bytes:\n");
@@ -663,9 +748,22 @@ decode_R2004(Bit_Chain* dat, Dwg_Data * dwg)
          ss.fields.comp_data_size, ss.fields.decomp_data_size);
     }
 
+  dwg->stats.locate_time += dwg_stats_clock(dwg) - start;
+
+  start = dwg_stats_clock(dwg);
   read_2004_section_classes(dat, dwg);
+  dwg->stats.classes_time += dwg_stats_clock(dwg) - start;
+
+  start = dwg_stats_clock(dwg);
   read_2004_section_header(dat, dwg);
+  dwg->stats.header_time += dwg_stats_clock(dwg) - start;
+
+  /* Object map, less the objects decoded as it is read */
+  start = dwg_stats_clock(dwg);
+  objects_time = dwg->stats.objects_time;
   read_2004_section_handles(dat, dwg);
+  dwg->stats.object_map_time += dwg_stats_clock(dwg) - start
+    - (dwg->stats.objects_time - objects_time);
 
   /* Clean up */
   if (dwg->header.section_info != 0)
@@ -675,6 +773,7 @@ decode_R2004(Bit_Chain* dat, Dwg_Data * dwg)
           free(dwg->header.section_info[i].sections);
 
       free(dwg->header.section_info);
+      dwg->header.section_info = 0;
       dwg->header.num_descriptions = 0;
     }
 
@@ -18,8 +18,8 @@
  * modified by Till Heuschmann
  */
 
-#ifndef _DWG_OBJECT_H_
-#define _DWG_OBJECT_H_
+#ifndef DECODE_R2004_H
+#define DECODE_R2004_H
 
 #include "config.h"
 #include <stdbool.h>
@@ -36,14 +36,9 @@
 int
 decode_R2004(Bit_Chain* dat, Dwg_Data * dwg);
 
-int
-read_long_compression_offset(Bit_Chain* dat);
-
-int
-read_two_byte_offset(Bit_Chain* dat, int* lit_length);
-
 int
 decompress_R2004_section(Bit_Chain* dat, char *decomp,
+                         unsigned long int decomp_data_size,
                          unsigned long int comp_data_size);
 
 Dwg_Section*
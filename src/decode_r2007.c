@@ -20,12 +20,14 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include <stdbool.h>
-#include "bits.h"
+#include <string.h>
+#include "decode_r2007.h"
 #include "logging.h"
 
-static unsigned int loglevel;
-
-#define DWG_LOGLEVEL loglevel
+#ifdef USE_TRACING
+#undef DWG_LOGLEVEL
+#define DWG_LOGLEVEL DWG_DECODE_LOGLEVEL
+#endif
 
 typedef struct r2007_file_header
 {
@@ -154,13 +156,26 @@ copy_bytes_16(char *dst, char *src)
   return dst + 16;
 }
 
-void 
+/* Copy a match of length bytes from offset bytes back.  A match
+ * overlapping its own output repeats with a period of offset, so it is
+ * copied in chunks doubling from that size, each reading only bytes
+ * already written.
+ */
+static void
 copy_bytes(char *dst, uint32_t length, uint32_t offset)
 {
-  char *src = dst - offset;
-  
-  while (length-- > 0)
-    *dst++ = *src++;
+  const char *src = dst - offset;
+  uint32_t chunk;
+
+  while (length > 0)
+    {
+      chunk = dst - src;
+      if (chunk > length)
+        chunk = length;
+      memcpy(dst, src, chunk);
+      dst += chunk;
+      length -= chunk;
+    }
 }
 
 
@@ -409,13 +424,18 @@ read_instructions(unsigned char **src, unsigned char *opcode, uint32_t *offset,
 
 /* See spec version 5.0 pp. 29 */
 int 
-decompress_r2007(char *dst, int dst_size, char *src, int src_size)
+decompress_r2007(char *dst, int dst_size, char *source, int src_size)
 {
   uint32_t length = 0;
   uint32_t offset = 0;
   
+  char *dst_start = dst;
   char *dst_end = dst + dst_size;
-  char *src_end = src + src_size;
+  /* read_literal_length and read_instructions move src through an
+     unsigned char **, so it must be one: a char * moved that way breaks
+     the aliasing rules, and the moves were lost at -O2.  */
+  unsigned char *src = (unsigned char*)source;
+  unsigned char *src_end = src + src_size;
   
   unsigned char opcode = *src++;
   
@@ -431,12 +451,12 @@ decompress_r2007(char *dst, int dst_size, char *src, int src_size)
   while (src < src_end)
     {   
       if (length == 0)
-	      length = read_literal_length((unsigned char**)&src, opcode);
+	      length = read_literal_length(&src, opcode);
       
-      if ((dst + length) > dst_end)
+      if (length > dst_end - dst || length > src_end - src)
         return 1;
       
-      copy_compressed_bytes(dst, src, length);
+      copy_compressed_bytes(dst, (char*)src, length);
       
       dst += length;
       src += length;
@@ -448,10 +468,13 @@ decompress_r2007(char *dst, int dst_size, char *src, int src_size)
       
       opcode = *src++;
       
-      read_instructions((unsigned char**)&src, &opcode, &offset, &length);
+      read_instructions(&src, &opcode, &offset, &length);
       
       while (1)
         {
+          if (offset == 0 || offset > dst - dst_start
+              || length > dst_end - dst)
+            return 1;
           copy_bytes(dst, length, offset);
         
           dst += length;
@@ -468,7 +491,7 @@ decompress_r2007(char *dst, int dst_size, char *src, int src_size)
           if ((opcode >> 4) == 0x0f)
             opcode &= 0xf;
         
-          read_instructions((unsigned char**)&src, &opcode, &offset, &length);
+          read_instructions(&src, &opcode, &offset, &length);
         } 
     }
   
@@ -476,40 +499,43 @@ decompress_r2007(char *dst, int dst_size, char *src, int src_size)
 }
 
 
-char*
-decode_rs(const char *src, int block_count, int data_size)
+/* Codewords de-interleaved at a time by decode_rs */
+#define RS_TILE 16
+
+/* De-interleave block_count Reed-Solomon codewords from src into dst,
+ * keeping the data_size data bytes of each: byte j of codeword i is at
+ * src[j * block_count + i].  The codewords are done RS_TILE at a time,
+ * so that the rows they fill in dst stay in cache while src is read in
+ * order.
+ */
+static void
+decode_rs(char *dst, const char *src, int block_count, int data_size)
 {
-  int i, j;
-  const char *src_base = src;
-  char *dst_base, *dst;  
-  
-  dst_base = dst = (char*)malloc(block_count * data_size);
-  
-  for (i = 0; i < block_count; ++i)
-    {      
-      for (j = 0; j < data_size; ++j)
+  int i, j, k, tile;
+  const char *s;
+  char *d;
+
+  for (i = 0; i < block_count; i += RS_TILE)
+    {
+      tile = block_count - i < RS_TILE ? block_count - i : RS_TILE;
+      for (j = 0; j < data_size; j++)
         {
-          *dst++ = *src;
-          src += block_count;
+          s = &src[j * block_count + i];
+          d = &dst[i * data_size + j];
+          for (k = 0; k < tile; k++)
+            d[k * data_size] = s[k];
         }
-      
-      src = ++src_base;
     }
-  
-  return (dst_base);
 }
 
 char*
 read_system_page(Bit_Chain* dat, int64_t size_comp, int64_t size_uncomp,
                  int64_t repeat_count)
 {
-  int i;
-  
   int64_t pesize;      // Pre RS encoded size
   int64_t block_count; // Number of RS encoded blocks
   int64_t page_size;
   
-  char *rsdata;        // RS encoded data
   char *pedata;        // Pre RS encoded data
   char *data;          // The data RS unencoded and uncompressed
   
@@ -523,63 +549,62 @@ read_system_page(Bit_Chain* dat, int64_t size_comp, int64_t size_uncomp,
   page_size = (block_count * 255 + 7) & ~7;
   
   
-  data = (char*)malloc(size_uncomp + page_size);
+  if (page_size > (int64_t) (dat->size - dat->byte))
+    {
+      LOG_ERROR("System page past the end of the file\n")
+      return 0;
+    }
+  
+  data = (char*)malloc(size_uncomp + block_count * 239);
   if (data == 0)
     {
       //TODO: report error
       return 0;
     }
   
-  rsdata = &data[size_uncomp];
-  
-  for (i = 0; i < page_size; i++)
-    rsdata[i] = bit_read_RC(dat);
-  
-  pedata = decode_rs(rsdata, block_count, 239);
+  // The RS encoded data is read in place from the file
+  pedata = &data[size_uncomp];
+  decode_rs(pedata, (char*)&dat->chain[dat->byte], block_count, 239);
+  dat->byte += page_size;
   
   if (size_comp < size_uncomp)
     decompress_r2007(data, size_uncomp, pedata, size_comp);
   else
     memcpy(data, pedata, size_uncomp);
   
-  free(pedata);
-  
   return data;
 }
 
+/* Read the data page of page_size bytes at dat into decomp, of
+ * size_uncomp bytes.  pedata is scratch space of page_size bytes, for
+ * the RS decoded data.
+ */
 int
 read_data_page(Bit_Chain* dat, unsigned char *decomp, int64_t page_size, 
-               int64_t size_comp, int64_t size_uncomp)
+               int64_t size_comp, int64_t size_uncomp, char *pedata)
 {
-  int i;
-  
   int64_t pesize;      // Pre RS encoded size
   int64_t block_count; // Number of RS encoded blocks
   
-  char *rsdata;        // RS encoded data
-  char *pedata;        // Pre RS encoded data
-  
     // Round to a multiple of 8
   pesize = ((size_comp + 7) & ~7);
   
   block_count = (pesize + 0xFB - 1) / 0xFB;
   
-  rsdata = (char*)malloc(page_size * sizeof(char));
-  if (rsdata == NULL)
+  if (block_count * 0xFF > page_size
+      || page_size > (int64_t) (dat->size - dat->byte))
     return 1;
   
-  for (i = 0; i < page_size; i++)
-    rsdata[i] = bit_read_RC(dat);  
-  
-  pedata = decode_rs(rsdata, block_count, 0xFB);
+  // The RS encoded data is read in place from the file
+  decode_rs(pedata, (char*)&dat->chain[dat->byte], block_count, 0xFB);
+  dat->byte += page_size;
   
   if (size_comp < size_uncomp)
-    decompress_r2007((char*)decomp, size_uncomp, pedata, size_comp);
-  else
-    memcpy(decomp, pedata, size_uncomp);
-  
-  free(pedata);
+    return decompress_r2007((char*)decomp, size_uncomp, pedata, size_comp);
   
+  if (size_uncomp > block_count * 0xFB)
+    return 1;
+  memcpy(decomp, pedata, size_uncomp);
   return 0;
 }
 
@@ -591,6 +616,8 @@ read_data_section(Bit_Chain *sec_dat, Bit_Chain *dat, r2007_section *sections_ma
   r2007_page *page;
   int64_t max_decomp_size;
   unsigned char *decomp;
+  char *pedata = 0, *new_pedata;
+  int64_t pedata_size = 0;
   int i;
   
   section = get_section(sections_map, hashcode);
@@ -608,24 +635,47 @@ read_data_section(Bit_Chain *sec_dat, Bit_Chain *dat, r2007_section *sections_ma
       page = get_page(pages_map, section->pages[i]->id);
       if (page == NULL)
         {
+          free(pedata);
           free(decomp);
           return 3;   // Failed to find page
         }
     
+      // One scratch buffer, for the largest page, serves all of them
+      if (page->size > pedata_size)
+        {
+          new_pedata = (char *)realloc(pedata, page->size);
+          if (new_pedata == NULL)
+            {
+              free(pedata);
+              free(decomp);
+              return 2;   // No memory
+            }
+          pedata = new_pedata;
+          pedata_size = page->size;
+        }
+    
       dat->byte = page->offset; 
-      if (read_data_page(dat, &decomp[section->pages[i]->offset], page->size, 
-                         section->pages[i]->comp_size, section->pages[i]->uncomp_size) != 0)
+      if (section->pages[i]->offset < 0 || section->pages[i]->uncomp_size < 0
+          || section->pages[i]->uncomp_size
+             > max_decomp_size - section->pages[i]->offset
+          || read_data_page(dat, &decomp[section->pages[i]->offset], page->size, 
+                            section->pages[i]->comp_size,
+                            section->pages[i]->uncomp_size, pedata) != 0)
         {
+          free(pedata);
           free(decomp);
           return 4;   // Failed to read page
         }
     }
   
+  free(pedata);
+  
   sec_dat->bit     = 0;
   sec_dat->byte    = 0;
   sec_dat->chain   = decomp;
   sec_dat->size    = max_decomp_size;
   sec_dat->version = dat->version;    
+  sec_dat->context = dat->context;
   
   return 0;
 }
@@ -680,6 +730,8 @@ read_sections_map(Bit_Chain* dat, int64_t size_comp,
   int i;
   
   data = read_system_page(dat, size_comp, size_uncomp, correction);
+  if (data == NULL)
+    return NULL;
   
   ptr = data;
   ptr_end = data + size_uncomp;
@@ -876,34 +928,34 @@ sections_destroy(r2007_section *section)
     }
 }
 
-void 
+int
 read_file_header(Bit_Chain* dat, r2007_file_header *file_header)
 {
-  char data[0x3d8];
-  char *pedata;
+  char pedata[3 * 239];
   int64_t seqence_crc;
   int64_t seqence_key;
   int64_t compr_crc;
   int32_t compr_len;
-  int i;
   
-  dat->byte = 0x80;
-  for (i = 0; i < 0x3d8; i++)
-    data[i] = bit_read_RC(dat);
-  
-  pedata = decode_rs(data, 3, 239);
+  if (dat->size < 0x80 + 0x3d8)
+    {
+      LOG_ERROR("File header past the end of the file\n")
+      return 1;
+    }
+  decode_rs(pedata, (char*)&dat->chain[0x80], 3, 239);
+  dat->byte = 0x80 + 0x3d8;
   
   seqence_crc = *((int64_t*)pedata);
   seqence_key = *((int64_t*)&pedata[8]);
   compr_crc   = *((int64_t*)&pedata[16]);
   compr_len   = *((int32_t*)&pedata[24]);
   
-  if (compr_len > 0)
+  if (compr_len > 0 && compr_len <= (int32_t) sizeof(pedata) - 32)
     decompress_r2007((char*)file_header, 0x110, &pedata[32], compr_len);
   else
     memcpy(file_header, &pedata[32], sizeof(r2007_file_header));
   
-  free(pedata);
+  return 0;
 }
 
 int
@@ -911,11 +963,10 @@ read_r2007_meta_data(Bit_Chain *dat, Dwg_Data *dwg)
 {
   r2007_file_header file_header;
   r2007_page *pages_map, *page;
-  r2007_section *sections_map;
-   
-  loglevel = 9;
+  r2007_section *sections_map = 0;
 
-  read_file_header(dat, &file_header);
+  if (read_file_header(dat, &file_header) != 0)
+    return 1;
   
     // Pages Map
   dat->byte += 0x28;  // overread check data
@@ -923,6 +974,8 @@ read_r2007_meta_data(Bit_Chain *dat, Dwg_Data *dwg)
   
   pages_map = read_pages_map(dat, file_header.pages_map_size_comp,
     file_header.pages_map_size_uncomp, file_header.pages_map_correction);  
+  if (pages_map)
+    dwg->stats.bytes_decompressed += file_header.pages_map_size_uncomp;
   
     // Sections Map
   page = get_page(pages_map, file_header.sections_map_id);
@@ -932,6 +985,8 @@ read_r2007_meta_data(Bit_Chain *dat, Dwg_Data *dwg)
       dat->byte = page->offset;
       sections_map = read_sections_map(dat, file_header.sections_map_size_comp,
         file_header.sections_map_size_uncomp, file_header.sections_map_correction);
+      if (sections_map)
+        dwg->stats.bytes_decompressed += file_header.sections_map_size_uncomp;
     }
   
   // Section Classes
@@ -0,0 +1,37 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * decode_r2007.h: functions to decode R2007 (r21) files
+ * written by Till Heuschmann
+ */
+
+#ifndef DECODE_R2007_H
+#define DECODE_R2007_H
+
+#include "config.h"
+#include <stdint.h>
+
+#include "bits.h"
+#include "dwg.h"
+
+int
+decompress_r2007(char *dst, int dst_size, char *source, int src_size);
+
+int
+read_data_page(Bit_Chain* dat, unsigned char *decomp, int64_t page_size,
+               int64_t size_comp, int64_t size_uncomp, char *pedata);
+
+int
+read_r2007_meta_data(Bit_Chain *dat, Dwg_Data *dwg);
+
+#endif
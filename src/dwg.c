@@ -22,12 +22,25 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 #include "bits.h"
 #include "common.h"
+#include "arena.h"
 #include "decode.h"
 #include "dwg.h"
+#include "encode.h"
+#include "free.h"
+#include "object.h"
+#include "resolve_pointers.h"
 
 #include "logging.h"
 
@@ -37,12 +50,255 @@
 int
 dwg_read_file(char *filename, Dwg_Data * dwg_data)
 {
+  return dwg_read_file_ex(filename, dwg_data, 0);
+}
+
+/* Decode the size bytes at chain, which is never written to.  owner is
+ * one of DWG_CHAIN_*: unless the caller only lends it the chain, the
+ * decoder may keep pointing into it for the objects it left undecoded,
+ * and the caller must then hand the chain over to dwg_data.  If the
+ * decoding fails, nothing points into it.
+ */
+static int
+decode_chain(unsigned char *chain, size_t size, Dwg_Data * dwg_data,
+             unsigned char owner)
+{
+  Bit_Chain bit_chain;
+  int error;
+
+  if (size < 6)
+    {
+      LOG_ERROR("Not a DWG file: only %lu bytes.\n", (long unsigned int) size)
+      return -1;
+    }
+
+  bit_chain.bit = 0;
+  bit_chain.byte = 0;
+  bit_chain.size = size;
+  bit_chain.chain = chain;
+
+  dwg_data->bit_chain = &bit_chain;
+  dwg_data->object_chain_owner = owner;
+  error = dwg_decode_data(&bit_chain, dwg_data);
+  dwg_data->read_options = 0;
+
+  /* The caller releases chain if the decoding failed.  */
+  if (dwg_data->object_chain == chain && error)
+    dwg_data->object_chain = 0;
+  if (!dwg_data->object_chain)
+    {
+      dwg_data->object_chain_size = 0;
+      dwg_data->object_chain_owner = DWG_CHAIN_BORROWED;
+    }
+  return error;
+}
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+/* Returned by decode_mapped_file when the file could not be mapped:
+ * dwg_data is untouched then, and the file may still be read.
+ */
+#define MAP_UNAVAILABLE 1
+
+/* Decode the size bytes of the file open on fd straight from a read-only
+ * mapping of it.  Everything the decoder keeps is copied out of the
+ * chain, so the mapping is gone again when this returns, unless the
+ * load is lazy.  Returns 0, -1 if the decoding failed, or
+ * MAP_UNAVAILABLE.
+ */
+static int
+decode_mapped_file(int fd, size_t size, Dwg_Data * dwg_data)
+{
+  void *map;
+  int error;
+
+  map = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED)
+    {
+      LOG_INFO("Could not map the file into memory, reading it.\n")
+      return MAP_UNAVAILABLE;
+    }
+#ifdef HAVE_MADVISE
+  madvise(map, size, MADV_SEQUENTIAL);
+#endif
+
+  dwg_data->opts |= DWG_OPT_MMAP;
+  error = decode_chain((unsigned char *) map, size, dwg_data,
+                       DWG_CHAIN_MAPPED);
+  dwg_data->opts &= ~DWG_OPT_MMAP;
+
+  /* A lazy load decodes the objects from the mapping later on.  */
+  if (dwg_data->object_chain == map)
+    {
+#ifdef HAVE_MADVISE
+      madvise(map, size, MADV_RANDOM);
+#endif
+      return 0;
+    }
+  munmap(map, size);
+  return error;
+}
+#endif /* HAVE_SYS_MMAN_H && HAVE_MMAP */
+
+/* Start a read of dwg_data with options, which may be NULL.
+ */
+static void
+read_init(Dwg_Data * dwg_data, const Dwg_Read_Options * options)
+{
+  memset(dwg_data, 0, sizeof(Dwg_Data));
+  if (options)
+    {
+      dwg_data->opts = options->flags;
+      dwg_data->read_options = options;
+    }
+}
+
+/* Decode a DWG file held in memory.  buf is borrowed: the caller keeps
+ * ownership of it and may free it as soon as this returns, the objects a
+ * lazy or filtered load leaves undecoded being copied out of it.
+ */
+int
+dwg_read_buffer(const unsigned char *buf, size_t len, Dwg_Data * dwg_data)
+{
+  return dwg_read_buffer_opts(buf, len, dwg_data, 0);
+}
+
+/* Like dwg_read_buffer, with the given read options.
+ */
+int
+dwg_read_buffer_opts(const unsigned char *buf, size_t len,
+                     Dwg_Data * dwg_data, const Dwg_Read_Options * options)
+{
+  read_init(dwg_data, options);
+  if (decode_chain((unsigned char *) buf, len, dwg_data,
+                   DWG_CHAIN_BORROWED))
+    {
+      LOG_ERROR("Failed to decode buffer.\n")
+      return -1;
+    }
+  return 0;
+}
+
+/* Decode the DWG file open on fd, which is left open.  Regular files are
+ * mapped, or read if they cannot be, from their start whatever the file
+ * offset, which is left as it was; anything else, such as a pipe or a
+ * socket, is read from the current offset up to end of file.
+ */
+int
+dwg_read_fd(int fd, Dwg_Data * dwg_data)
+{
+  return dwg_read_fd_opts(fd, dwg_data, 0);
+}
+
+/* Like dwg_read_fd, with the given read options.
+ */
+int
+dwg_read_fd_opts(int fd, Dwg_Data * dwg_data, const Dwg_Read_Options * options)
+{
+  struct stat attrib;
+  unsigned char *chain;
+  size_t size, alloced;
+  ssize_t got;
+  int error;
+
+  read_init(dwg_data, options);
+  if (fstat(fd, &attrib))
+    {
+      LOG_ERROR("Could not stat file descriptor %d\n", fd)
+      return -1;
+    }
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+  if (S_ISREG (attrib.st_mode) && attrib.st_size > 0)
+    {
+      error = decode_mapped_file(fd, attrib.st_size, dwg_data);
+      if (error != MAP_UNAVAILABLE)
+        {
+          if (error)
+            {
+              LOG_ERROR("Failed to decode file descriptor %d\n", fd)
+              return -1;
+            }
+          return 0;
+        }
+    }
+#endif /* HAVE_SYS_MMAN_H && HAVE_MMAP */
+
+  size = 0;
+  alloced = S_ISREG (attrib.st_mode) && attrib.st_size > 0
+      ? attrib.st_size : 65536;
+  chain = (unsigned char *) malloc(alloced);
+  if (!chain)
+    {
+      LOG_ERROR("Not enough memory.\n")
+      return -1;
+    }
+  for (;;)
+    {
+      if (size == alloced)
+        {
+          unsigned char *bigger = (unsigned char *) realloc(chain, 2 * alloced);
+
+          if (!bigger)
+            {
+              LOG_ERROR("Not enough memory.\n")
+              free(chain);
+              return -1;
+            }
+          chain = bigger;
+          alloced *= 2;
+        }
+      if (S_ISREG (attrib.st_mode))
+        got = pread(fd, chain + size, alloced - size, size);
+      else
+        got = read(fd, chain + size, alloced - size);
+      if (got == 0)
+        break;
+      if (got < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          LOG_ERROR("Could not read file descriptor %d\n", fd)
+          free(chain);
+          return -1;
+        }
+      size += got;
+    }
+
+  error = decode_chain(chain, size, dwg_data, DWG_CHAIN_MALLOCED);
+  if (dwg_data->object_chain != chain)
+    free(chain);
+  if (error)
+    {
+      LOG_ERROR("Failed to decode file descriptor %d\n", fd)
+      return -1;
+    }
+  return 0;
+}
+
+int
+dwg_read_file_ex(char *filename, Dwg_Data * dwg_data, unsigned int opts)
+{
+  Dwg_Read_Options options;
+
+  memset(&options, 0, sizeof(options));
+  options.flags = opts;
+  return dwg_read_file_opts(filename, dwg_data, &options);
+}
+
+/* Read filename with the given options, which may be NULL.
+ */
+int
+dwg_read_file_opts(char *filename, Dwg_Data * dwg_data,
+                   const Dwg_Read_Options * options)
+{
+  unsigned int opts = options ? options->flags : 0;
   int sign;
   FILE *fp;
   struct stat attrib;
   size_t size;
-  Bit_Chain bit_chain;
+  unsigned char *chain;
 
+  read_init(dwg_data, options);
   if (stat(filename, &attrib))
     {
       LOG_ERROR("File not found: %s\n", filename)
@@ -53,6 +309,32 @@ dwg_read_file(char *filename, Dwg_Data * dwg_data)
       LOG_ERROR("Error: %s\n", filename)
       return -1;
     }
+  dwg_data->opts &= ~DWG_OPT_MMAP;
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+  if ((opts & DWG_OPT_MMAP) && attrib.st_size > 0)
+    {
+      int fd = open(filename, O_RDONLY);
+
+      if (fd < 0)
+        {
+          LOG_ERROR("Could not open file: %s\n", filename)
+          return -1;
+        }
+      sign = decode_mapped_file(fd, attrib.st_size, dwg_data);
+      close(fd);
+      if (sign != MAP_UNAVAILABLE)
+        {
+          if (sign)
+            {
+              LOG_ERROR("Failed to decode file: %s\n", filename)
+              return -1;
+            }
+          return 0;
+        }
+    }
+#endif /* HAVE_SYS_MMAN_H && HAVE_MMAP */
+
   fp = fopen(filename, "rb");
   if (!fp)
     {
@@ -62,39 +344,36 @@ dwg_read_file(char *filename, Dwg_Data * dwg_data)
 
   /* Load file to memory
    */
-  bit_chain.bit = 0;
-  bit_chain.byte = 0;
-  bit_chain.size = attrib.st_size;
-  bit_chain.chain = (unsigned char *) malloc(bit_chain.size);
-  if (!bit_chain.chain)
+  chain = (unsigned char *) malloc(attrib.st_size);
+  if (!chain)
     {
       LOG_ERROR("Not enough memory.\n")
       fclose(fp);
       return -1;
     }
   size = 0;
-  size = fread(bit_chain.chain, sizeof(char), bit_chain.size, fp);
-  if (size != bit_chain.size)
+  size = fread(chain, sizeof(char), attrib.st_size, fp);
+  if (size != attrib.st_size)
     {
       LOG_ERROR("Could not read the entire file (%lu out of %lu): %s\n",
-          (long unsigned int) size, bit_chain.size, filename)
+          (long unsigned int) size, (long unsigned int) attrib.st_size,
+          filename)
       fclose(fp);
-      free(bit_chain.chain);
+      free(chain);
       return -1;
     }
   fclose(fp);
 
   /* Decode the dwg structure
    */
-  dwg_data->bit_chain = &bit_chain;
-
-  if (dwg_decode_data(&bit_chain, dwg_data))
+  if (decode_chain(chain, size, dwg_data, DWG_CHAIN_MALLOCED))
     {
       LOG_ERROR("Failed to decode file: %s\n", filename)
-      free(bit_chain.chain);
+      free(chain);
       return -1;
     }
-  free(bit_chain.chain);
+  if (dwg_data->object_chain != chain)
+    free(chain);
 
   return 0;
 }
@@ -106,49 +385,85 @@ dwg_read_file(char *filename, Dwg_Data * dwg_data)
 int
 dwg_write_file(char *filename, Dwg_Data * dwg_data)
 {
-  FILE *dt;
-  struct stat atrib;
+  int fd, error;
+
+  // try opening the output file in write mode
+  fd = open(filename, O_WRONLY | O_CREAT | O_EXCL, 0666);
+  if (fd < 0)
+    {
+      if (errno == EEXIST)
+        {
+          LOG_ERROR("The file already exists. We won't overwrite it.")
+        }
+      else
+        {
+          LOG_ERROR("Failed to create the file: %s\n", filename)
+        }
+      return -1;
+    }
+
+  error = dwg_write_fd(fd, dwg_data);
+  if (close(fd))
+    error = -1;
+  if (error)
+    {
+      LOG_ERROR("Failed to write data into the file: %s\n", filename)
+      unlink(filename);
+    }
+  return error;
+}
+
+/* Encode dwg_data to the file descriptor fd, which is not closed.  A
+ * regular file is written as it is encoded, through a bounded buffer;
+ * anything else (a pipe, a socket) gets the file encoded in memory
+ * first.
+ */
+int
+dwg_write_fd(int fd, Dwg_Data * dwg_data)
+{
+  struct stat attrib;
   Bit_Chain bit_chain;
-  bit_chain.version = (Dwg_Version_Type)dwg_data->header.version;
+  long unsigned int done;
+  ssize_t written;
 
-  // Encode the DWG struct
-   bit_chain.size = 0;
-   if (dwg_encode_chains (dwg_data, &bit_chain))
-   {
-   LOG_ERROR("Failed to encode datastructure.\n")
-   if (bit_chain.size > 0)
-   free (bit_chain.chain);
-   return -1;
-   }
- 
+  if (fstat(fd, &attrib))
+    {
+      LOG_ERROR("Could not stat file descriptor %d\n", fd)
+      return -1;
+    }
+  if (S_ISREG (attrib.st_mode))
+    {
+      if (dwg_encode_fd(dwg_data, fd))
+        {
+          LOG_ERROR("Failed to encode datastructure.\n")
+          return -1;
+        }
+      return 0;
+    }
 
-  // try opening the output file in write mode
-   if (!stat (filename, &atrib))
-   {
-   LOG_ERROR("The file already exists. We won't overwrite it.")
-   return -1;
-   }
-   dt = fopen (filename, "w");
-   if (!dt)
-   {
-   LOG_ERROR("Failed to create the file: %s\n", filename)
-   return -1;
-   }
-   
-
-  // Write the data into the file
-   if (fwrite (bit_chain.chain, sizeof (char), bit_chain.size, dt) != bit_chain.size)
-   {
-   LOG_ERROR("Failed to write data into the file: %s\n", filename)
-   fclose (dt);
-   free (bit_chain.chain);
-   return -1;
-   }
-   fclose (dt);
-
-   if (bit_chain.size > 0)
-   free (bit_chain.chain);
+  // Encode the DWG struct
+  memset(&bit_chain, 0, sizeof(bit_chain));
+  bit_chain.version = (Dwg_Version_Type)dwg_data->header.version;
+  if (dwg_encode_chains (dwg_data, &bit_chain))
+    {
+      LOG_ERROR("Failed to encode datastructure.\n")
+      free (bit_chain.chain);
+      return -1;
+    }
 
+  for (done = 0; done < bit_chain.size; done += written)
+    {
+      written = write(fd, bit_chain.chain + done, bit_chain.size - done);
+      if (written < 0 && errno == EINTR)
+        written = 0;
+      else if (written <= 0)
+        {
+          LOG_ERROR("Could not write to file descriptor %d\n", fd)
+          free (bit_chain.chain);
+          return -1;
+        }
+    }
+  free (bit_chain.chain);
   return 0;
 }
 #endif /* USE_WRITE */ 
@@ -274,6 +589,8 @@ dwg_page_y_max(Dwg_Data *dwg)
 unsigned int
 dwg_get_layer_count(Dwg_Data *dwg)
 {
+  if (!dwg->layer_control || dwg_decode_lazy_object(dwg, dwg->layer_control))
+    return 0;
   return dwg->layer_control->tio.object->tio.LAYER_CONTROL->num_entries;
 }
 
@@ -285,8 +602,11 @@ dwg_get_layers(Dwg_Data *dwg)
 		dwg_get_layer_count(dwg) * sizeof (Dwg_Object_LAYER*));
   for (i=0; i<dwg_get_layer_count(dwg); i++)
     {
-      layers[i] = dwg->layer_control->tio.object->tio.LAYER_CONTROL->
-            layers[i]->obj->tio.object->tio.LAYER;
+      Dwg_Object *obj = dwg->layer_control->tio.object->tio.LAYER_CONTROL->
+            layers[i]->obj;
+
+      dwg_decode_lazy_object(dwg, obj);
+      layers[i] = obj->tio.object->tio.LAYER;
     }
   return layers;
 }
@@ -329,7 +649,10 @@ dwg_get_entities(Dwg_Data *dwg)
 Dwg_Object_LAYER *
 dwg_get_entity_layer(Dwg_Object_Entity * ent)
 {
-  return ent->layer->obj->tio.object->tio.LAYER;
+  Dwg_Object *obj = ent->layer->obj;
+
+  dwg_decode_lazy_object(obj->parent, obj);
+  return obj->tio.object->tio.LAYER;
 }
 
 Dwg_Object*
@@ -340,6 +663,38 @@ dwg_next_object(Dwg_Object* obj)
   return &obj->parent->object[obj->index+1];
 }
 
+Dwg_Object*
+dwg_find_object_by_handle(Dwg_Data *dwg, long unsigned int handle)
+{
+  Dwg_Object *obj;
+
+  if (!dwg->handle_index || dwg->num_handle_index != dwg->num_objects)
+    {
+      if (dwg_build_handle_index(dwg))
+        return 0;
+    }
+  obj = dwg_resolve_handle(dwg, handle);
+  if (obj)
+    dwg_decode_lazy_object(dwg, obj);
+  return obj;
+}
+
+/* Return object number index of dwg, decoding it first if the load was
+ * lazy.
+ */
+Dwg_Object*
+dwg_get_object_decoded(Dwg_Data *dwg, long unsigned int index)
+{
+  Dwg_Object *obj;
+
+  if (index >= dwg->num_objects)
+    return 0;
+  obj = &dwg->object[index];
+  if (dwg_decode_lazy_object(dwg, obj))
+    return 0;
+  return obj;
+}
+
 int
 dwg_get_object(Dwg_Object* obj, Dwg_Object_Ref* ref)
 {
@@ -386,6 +741,61 @@ Dwg_Object* get_next_owned_object(Dwg_Object* hdr_obj, Dwg_Object* current, Dwg_
 void
 dwg_free(Dwg_Data * dwg)
 {
-  if (dwg->header.section)
-    free(dwg->header.section);
+  long unsigned int i;
+
+  /* With an arena, everything the objects point to lives in it.  */
+  if (!dwg->arena)
+    {
+      for (i = 0; i < dwg->num_objects; i++)
+        dwg_free_object(&dwg->object[i]);
+      dwg_free_header_vars(dwg);
+      for (i = 0; i < dwg->num_classes; i++)
+        {
+          free(dwg->dwg_class[i].appname);
+          free(dwg->dwg_class[i].cppname);
+          free(dwg->dwg_class[i].dxfname);
+        }
+      for (i = 0; i < dwg->num_object_refs; i++)
+        free(dwg->object_ref[i]);
+      free(dwg->unknown1.chain);
+      free(dwg->picture.chain);
+    }
+  dwg_arena_destroy(dwg->arena);
+  dwg->arena = 0;
+
+  if (dwg->object_chain_owner == DWG_CHAIN_MALLOCED)
+    free(dwg->object_chain);
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+  else if (dwg->object_chain_owner == DWG_CHAIN_MAPPED)
+    munmap(dwg->object_chain, dwg->object_chain_size);
+#endif
+  dwg->object_chain = 0;
+  dwg->object_chain_size = 0;
+  dwg->object_chain_owner = DWG_CHAIN_BORROWED;
+  dwg->unknown1.chain = 0;
+  dwg->picture.chain = 0;
+
+  /* The vectors that grow while decoding are always on the heap.  */
+  free(dwg->object);
+  dwg->object = 0;
+  dwg->num_objects = 0;
+  dwg->num_alloced_objects = 0;
+  free(dwg->object_ref);
+  dwg->object_ref = 0;
+  dwg->num_object_refs = 0;
+  free(dwg->dwg_class);
+  dwg->dwg_class = 0;
+  dwg->num_classes = 0;
+  free(dwg->handle_index);
+  dwg->handle_index = 0;
+  dwg->num_handle_index = 0;
+
+  for (i = 0; i < dwg->header.num_descriptions; i++)
+    free(dwg->header.section_info[i].sections);
+  free(dwg->header.section_info);
+  dwg->header.section_info = 0;
+  dwg->header.num_descriptions = 0;
+  free(dwg->header.section);
+  dwg->header.section = 0;
+  dwg->header.num_sections = 0;
 }
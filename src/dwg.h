@@ -21,6 +21,10 @@
 #ifndef DWG_H
 #define DWG_H
 
+#ifndef SWIG
+#include <stddef.h>
+#endif
+
 #ifdef __cplusplus
 //extern "C"
 //  {
@@ -104,7 +108,8 @@ typedef struct _dwg_bitecode_3bd
  */
 typedef enum DWG_OBJECT_SUPERTYPE
 {
-  DWG_SUPERTYPE_UNKNOWN, DWG_SUPERTYPE_ENTITY, DWG_SUPERTYPE_OBJECT
+  DWG_SUPERTYPE_UNKNOWN, DWG_SUPERTYPE_ENTITY, DWG_SUPERTYPE_OBJECT,
+  DWG_SUPERTYPE_UNDECODED /* left out by the read filter */
 } Dwg_Object_Supertype;
 
 /**
@@ -2692,6 +2697,9 @@ typedef struct _dwg_object
   unsigned int ckr;
   unsigned int index;
 
+  /* Offset of the object (its size field) in the decoded chain.  */
+  long unsigned int address;
+
   Dwg_Object_Supertype supertype;
   union
   {
@@ -2706,6 +2714,8 @@ typedef struct _dwg_object
 
 } Dwg_Object;
 
+struct _bit_chain;
+
 /**
  Struct for classes
  */
@@ -2718,8 +2728,75 @@ typedef struct _dwg_class
   unsigned char *dxfname;
   unsigned char wasazombie;
   unsigned int item_class_id;
+
+  /** Decoder of the objects of this class, looked up from dxfname when
+      the class is read; NULL if the class is not supported.  */
+  void (*decode) (struct _bit_chain *dat, Dwg_Object *obj);
+
+  /** Nonzero if the read filter leaves the objects of this class
+      undecoded.  */
+  unsigned char skip;
 } Dwg_Class;
 
+/**
+ Entry of the handle index: maps a handle value to its place in the object
+ vector.  The index is kept sorted by handle value.
+ */
+typedef struct _dwg_handle_index
+{
+  long unsigned int handle;
+  long unsigned int index;
+} Dwg_Handle_Index;
+
+/**
+ Statistics collected while a drawing is loaded, by dwg_decode_data, and
+ read by dwg_get_load_stats.  The counters are always kept; the times,
+ in seconds of a monotonic clock, only with DWG_OPT_STATS.
+ */
+typedef struct _dwg_load_stats
+{
+  /* Time in each phase.  The objects are decoded as the object map (the
+     handles section since R2004) is read: object_map_time is the map
+     alone, objects_time the decoding.  */
+  double locate_time;     /* section locators, or section maps and info */
+  double header_time;     /* header variables */
+  double classes_time;
+  double object_map_time;
+  double objects_time;
+  double resolve_time;    /* resolve_objectref_vector */
+  double total_time;      /* the whole of dwg_decode_data */
+
+  /* Bytes the compressed sections (R2004 and later) expanded to.  */
+  long unsigned int bytes_decompressed;
+
+  /* Objects of each fixed type, and of the classes (types 500 and up,
+     or unknown).  */
+  long unsigned int objects_by_type[DWG_TYPE_LAYOUT + 1];
+  long unsigned int class_objects;
+
+  /* Allocations of the decoded data (dwg_malloc, dwg_calloc and
+     dwg_realloc), and their bytes: the objects with their fields and
+     strings, the header variables, the class names, the picture and
+     the unknown section, and the handle references.  Not the vectors
+     of objects (see object_allocs), of handle references, of classes
+     and of sections, nor the handle index, which grow on the heap, nor
+     the file and the decompressed sections (see bytes_decompressed),
+     freed with the load.  */
+  long unsigned int allocs;
+  long unsigned int alloc_bytes;
+
+  /* Number of times the object vector was (re)allocated.  */
+  long unsigned int object_allocs;
+
+  /* Handle references resolved to an object of the drawing, and those
+     whose object is not in it; the null references count as neither.  */
+  long unsigned int refs_resolved;
+  long unsigned int refs_unresolved;
+
+  /* Sections whose CRC does not match.  */
+  long unsigned int crc_failures;
+} Dwg_Load_Stats;
+
 /**
  Dwg_Chain same as Bit_Chain in "bits.h"
  */
@@ -2801,6 +2878,7 @@ typedef struct _dwg_struct
   Dwg_Class * dwg_class;
 
   long unsigned int num_objects;
+  long unsigned int num_alloced_objects;
   Dwg_Object *object;
 
   long unsigned int num_layers;
@@ -2810,6 +2888,9 @@ typedef struct _dwg_struct
   long unsigned int num_object_refs;
   Dwg_Object_Ref ** object_ref;
 
+  long unsigned int num_handle_index;
+  Dwg_Handle_Index * handle_index;
+
   Dwg_Object * layer_control;
 
   struct
@@ -2828,8 +2909,68 @@ typedef struct _dwg_struct
 
   struct _bit_chain *bit_chain;
 
+  Dwg_Load_Stats stats;
+
+  unsigned int opts;
+
+  /* Owner of the decoded data with DWG_OPT_ARENA, else NULL.  */
+  struct _dwg_arena *arena;
+
+  /* Options of the read in progress, else NULL.  */
+  const struct _dwg_read_options *read_options;
+
+  /* When DWG_OPT_LAZY or DWG_OPT_FILTER left objects undecoded, the
+     chain they are decoded from, kept until dwg_free, and who owns it:
+     one of DWG_CHAIN_*.  During the read, the owner of the chain read.  */
+  unsigned char *object_chain;
+  long unsigned int object_chain_size;
+  unsigned char object_chain_owner;
+
 } Dwg_Data;
 
+/**
+ Options for dwg_read_file_ex
+ */
+#define DWG_OPT_MMAP 0x1  /* map the file instead of reading it into memory */
+#define DWG_OPT_ARENA 0x2 /* allocate the decoded data from one arena */
+#define DWG_OPT_FILTER 0x4 /* decode only the objects in the filter */
+#define DWG_OPT_LAZY 0x8 /* decode each object when it is first asked for */
+#define DWG_OPT_THREADS 0x10 /* decode and encode on several threads */
+#define DWG_OPT_NO_CRC 0x20  /* trust the input, skip the CRC checks */
+#define DWG_OPT_STATS 0x40   /* time the phases of the load */
+
+/* Owners of Dwg_Data.object_chain */
+#define DWG_CHAIN_BORROWED 0 /* none, or lent for the read only */
+#define DWG_CHAIN_MALLOCED 1 /* freed by dwg_free */
+#define DWG_CHAIN_MAPPED 2   /* unmapped by dwg_free */
+
+/**
+ Options for dwg_read_file_opts and friends.  With DWG_OPT_FILTER, the
+ objects of a fixed type are decoded only if their type is set in types
+ (see DWG_FILTER_TYPE), and the objects of a class only if its DXF name
+ is in classes, a NULL-terminated list.  The other objects are kept with
+ their handle and address only, as DWG_SUPERTYPE_UNDECODED, until
+ dwg_get_object_decoded decodes them.
+ */
+typedef struct _dwg_read_options
+{
+  unsigned int flags;
+  unsigned char types[DWG_TYPE_LAYOUT / 8 + 1];
+  const char **classes;
+
+  /* Threads to decode on with DWG_OPT_THREADS, and to load the files of
+     a batch on, 0 for one per processor.  */
+  unsigned int num_threads;
+
+  /* Bytes of files a batch loads at once, 0 for no limit.  */
+  long unsigned int batch_max_bytes;
+} Dwg_Read_Options;
+
+#define DWG_FILTER_TYPE(options, type) \
+  ((options)->types[(type) / 8] |= 1 << ((type) % 8))
+#define DWG_FILTER_HAS_TYPE(options, type) \
+  ((type) <= DWG_TYPE_LAYOUT && ((options)->types[(type) / 8] >> ((type) % 8) & 1))
+
 /*--------------------------------------------------
  * Functions
  */
@@ -2837,11 +2978,61 @@ typedef struct _dwg_struct
 int
 dwg_read_file(char *filename, Dwg_Data * dwg);
 
+int
+dwg_read_file_ex(char *filename, Dwg_Data * dwg, unsigned int opts);
+
+int
+dwg_read_buffer(const unsigned char *buf, size_t len, Dwg_Data * dwg);
+
+int
+dwg_read_fd(int fd, Dwg_Data * dwg);
+
+int
+dwg_read_file_opts(char *filename, Dwg_Data * dwg,
+                   const Dwg_Read_Options * options);
+
+int
+dwg_read_buffer_opts(const unsigned char *buf, size_t len, Dwg_Data * dwg,
+                     const Dwg_Read_Options * options);
+
+int
+dwg_read_fd_opts(int fd, Dwg_Data * dwg, const Dwg_Read_Options * options);
+
+/**
+ Load of one file of a batch, by dwg_read_files_batch
+ */
+typedef struct _dwg_batch_result
+{
+  const char *path;
+  unsigned int index;       /* of path in the batch */
+  long unsigned int size;   /* of the file, 0 if it cannot be stat'ed */
+  int error;                /* as returned by dwg_read_file_opts */
+  double wait_time;         /* seconds waiting for the memory to load it */
+  double load_time;         /* seconds loading it */
+} Dwg_Batch_Result;
+
+/* Called on each drawing of a batch, loaded or not (see result->error),
+   which is freed when this returns.  A nonzero return stops the batch. */
+typedef int (*Dwg_Batch_Callback) (Dwg_Data * dwg,
+                                   const Dwg_Batch_Result * result,
+                                   void *data);
+
+int
+dwg_read_files_batch(char **paths, unsigned int num_paths,
+                     const Dwg_Read_Options * options,
+                     Dwg_Batch_Callback callback, void *data);
+
 #ifdef USE_WRITE
 int
 dwg_write_file(char *filename, Dwg_Data * dwg_data);
+
+int
+dwg_write_fd(int fd, Dwg_Data * dwg_data);
 #endif
 
+int
+dwg_get_load_stats(Dwg_Data * dwg, Dwg_Load_Stats * stats);
+
 void
 dwg_free(Dwg_Data * dwg);
 unsigned char*
@@ -2886,6 +3077,12 @@ dwg_get_entity_layer(Dwg_Object_Entity *);
 Dwg_Object*
 dwg_next_object(Dwg_Object* obj);
 
+Dwg_Object*
+dwg_find_object_by_handle(Dwg_Data *dwg, long unsigned int handle);
+
+Dwg_Object*
+dwg_get_object_decoded(Dwg_Data *dwg, long unsigned int index);
+
 int
 dwg_get_object(Dwg_Object* obj, Dwg_Object_Ref* ref);
 
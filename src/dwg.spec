@@ -32,6 +32,12 @@
 #define DECODER if (0)
 #endif
 
+/* Freeing follows the decoder, to find what it allocated.  */
+#ifdef IS_FREE
+#define ENCODER if (0)
+#define DECODER if (1)
+#endif
+
 #define TODO_ENCODER fprintf(stderr, "TODO: Encoder\n");
 #define TODO_DECODER fprintf(stderr, "TODO: Decoder\n");
 
@@ -64,7 +70,7 @@ DWG_ENTITY (TEXT);
       FIELD(rotation_ang, BD);
       FIELD(height, BD);
       FIELD(width_factor, BD);
-      FIELD(text_value, TV);
+      FIELD_TV(text_value);
       FIELD(generation, BS);
       FIELD(horiz_alignment, BS);
       FIELD(vert_alignment, BS);
@@ -111,7 +117,7 @@ DWG_ENTITY (TEXT);
           FIELD(width_factor, RD);
         }
 
-      FIELD(text_value, TV);
+      FIELD_TV(text_value);
 
       if (!(FIELD_VALUE(dataflags) & 0x20))
         {
@@ -148,7 +154,7 @@ DWG_ENTITY(ATTRIB);
       FIELD(rotation_ang, BD);
       FIELD(height, BD);
       FIELD(width_factor, BD);
-      FIELD(text_value, TV);
+      FIELD_TV(text_value);
       FIELD(generation, BS);
       FIELD(horiz_alignment, BS);
       FIELD(vert_alignment, BS);
@@ -186,7 +192,7 @@ DWG_ENTITY(ATTRIB);
         {
           FIELD(width_factor, RD);
         }
-      FIELD(text_value, TV);
+      FIELD_TV(text_value);
       if (!(FIELD_VALUE(dataflags) & 0x20))
         {
           FIELD(generation, BS);
@@ -201,7 +207,7 @@ DWG_ENTITY(ATTRIB);
         }
     }
 
-  FIELD(tag, TV);
+  FIELD_TV(tag);
   FIELD(field_length, BS);
   FIELD(flags, RC);
 
@@ -230,7 +236,7 @@ DWG_ENTITY(ATTDEF);
       FIELD(rotation_ang, BD);
       FIELD(height, BD);
       FIELD(width_factor, BD);
-      FIELD(default_value, TV);
+      FIELD_TV(default_value);
       FIELD(generation, BS);
       FIELD(horiz_alignment, BS);
       FIELD(vert_alignment, BS);
@@ -268,7 +274,7 @@ DWG_ENTITY(ATTDEF);
         {
           FIELD(width_factor, RD);
         }
-      FIELD(default_value, TV);
+      FIELD_TV(default_value);
       if (!(FIELD_VALUE(dataflags) & 0x20))
         {
           FIELD(generation, BS);
@@ -283,7 +289,7 @@ DWG_ENTITY(ATTDEF);
         }
     }
 
-  FIELD(tag, TV);
+  FIELD_TV(tag);
   FIELD(field_length, BS);
   FIELD(flags, RC);
 
@@ -292,7 +298,7 @@ DWG_ENTITY(ATTDEF);
       FIELD(lock_position_flag, B);
     }
 
-  FIELD(prompt, TV);
+  FIELD_TV(prompt);
 
   COMMON_ENTITY_HANDLE_DATA;
 
@@ -303,7 +309,7 @@ DWG_ENTITY_END
 /*(4)*/
 DWG_ENTITY(BLOCK);
 
-  FIELD(name, TV);
+  FIELD_TV(name);
 
   COMMON_ENTITY_HANDLE_DATA;
 
@@ -1277,15 +1283,15 @@ void decode_3dsolid(Bit_Chain* dat, Dwg_Object* obj, Dwg_Entity_3DSOLID* _obj){
         {
           do
             {
-              FIELD_VALUE(sat_data) = (BITCODE_RC**) realloc(FIELD_VALUE(sat_data), i * sizeof(BITCODE_RC*));
-              FIELD_VALUE(block_size) = (BITCODE_BL*) realloc(FIELD_VALUE(block_size), i * sizeof(BITCODE_BL));
+              FIELD_VALUE(sat_data) = (BITCODE_RC**) dwg_realloc(dwg, FIELD_VALUE(sat_data), i * sizeof(BITCODE_RC*), (i + 1) * sizeof(BITCODE_RC*));
+              FIELD_VALUE(block_size) = (BITCODE_BL*) dwg_realloc(dwg, FIELD_VALUE(block_size), i * sizeof(BITCODE_BL), (i + 1) * sizeof(BITCODE_BL));
               FIELD_BL (block_size[i]);
               FIELD_VECTOR (sat_data[i], RC, block_size[i]);
               total_size += FIELD_VALUE(block_size[i]);
             } while(FIELD_VALUE(block_size[i++]));
 
           //de-obfuscate SAT data
-          FIELD_VALUE(raw_sat_data) = (unsigned char*) malloc (total_size * sizeof(unsigned char*));
+          FIELD_VALUE(raw_sat_data) = (unsigned char*) dwg_malloc (dwg, total_size * sizeof(unsigned char*));
           num_blocks=i-1;
           index=0;
           for (i=0;i<num_blocks;i++)
@@ -1369,6 +1375,41 @@ void decode_3dsolid(Bit_Chain* dat, Dwg_Object* obj, Dwg_Entity_3DSOLID* _obj){
         }
     }
 }
+#elif defined(IS_FREE)
+
+#define DECODE_3DSOLID free_3dsolid(dat, obj, _obj);
+
+static void free_3dsolid(Bit_Chain* dat, Dwg_Object* obj, Dwg_Entity_3DSOLID* _obj){
+  int rcount, rcount2;
+  int i;
+
+  if (!FIELD_VALUE(acis_empty))
+    {
+      if (FIELD_VALUE(version)==1 && FIELD_VALUE(block_size))
+        {
+          for (i = 0; FIELD_VALUE(block_size[i]); i++)
+            free(FIELD_VALUE(sat_data[i]));
+          FREE_IF(FIELD_VALUE(sat_data));
+          FREE_IF(FIELD_VALUE(block_size));
+          FREE_IF(FIELD_VALUE(raw_sat_data));
+        }
+
+      if (FIELD_VALUE(wireframe_data_present) && FIELD_VALUE(isoline_present))
+        {
+          REPEAT(num_wires, wires, Dwg_Entity_3DSOLID_wire)
+            {
+              PARSE_WIRE_STRUCT(wires[rcount])
+            }
+          REPEAT(num_silhouettes, silhouettes, Dwg_Entity_3DSOLID_silhouette)
+            {
+              REPEAT2(silhouettes[rcount].num_wires, silhouettes[rcount].wires, Dwg_Entity_3DSOLID_wire)
+                {
+                  PARSE_WIRE_STRUCT(silhouettes[rcount].wires[rcount2])
+                }
+            }
+        }
+    }
+}
 #else
 #define DECODE_3DSOLID {}
 #endif //#if IS_DECODER
@@ -1466,13 +1507,13 @@ DWG_OBJECT(DICTIONARY);
       return;
     }
 
-  FIELD_VECTOR(text, TV, numitems);
+  FIELD_VECTOR_T(text, numitems);
   FIELD_HANDLE(parenthandle, 4);
   REACTORS(4);
   XDICOBJHANDLE(3);
   HANDLE_VECTOR(itemhandles, numitems, 2);
 
-DWG_ENTITY_END
+DWG_OBJECT_END
 
 DWG_OBJECT(DICTIONARYWDLFT);
 	  
@@ -1489,7 +1530,7 @@ DWG_OBJECT(DICTIONARYWDLFT);
       FIELD(hard_owner, RC);
     }
 
-  FIELD_VECTOR(text, TV, numitems);
+  FIELD_VECTOR_T(text, numitems);
   
   FIELD_HANDLE(parenthandle, 4);
   REACTORS(4);
@@ -1522,7 +1563,7 @@ DWG_ENTITY(MTEXT);
   FIELD(drawing_dir, BS);
   FIELD(extends_ht, BD); //not documented
   FIELD(extends_wid, BD);
-  FIELD(text, TV);
+  FIELD_TV(text);
 
   SINCE(R_2000)
     {
@@ -1615,7 +1656,7 @@ DWG_ENTITY(TOLERANCE);
   FIELD_3DPOINT(ins_pt);
   FIELD_3DPOINT(x_direction);
   FIELD_3DPOINT(extrusion);
-  FIELD(text_string, TV);
+  FIELD_TV(text_string);
 
   COMMON_ENTITY_HANDLE_DATA;
   FIELD_HANDLE(dimstyle, 5);
@@ -1675,7 +1716,7 @@ DWG_OBJECT_END
 /*(49)*/
 DWG_OBJECT(BLOCK_HEADER);
 
-  FIELD(entry_name, TV);
+  FIELD_TV(entry_name);
   FIELD(_64_flag, B);
   FIELD(xrefindex_plus1, BS);
   FIELD(xdep, B);
@@ -1695,19 +1736,25 @@ DWG_OBJECT(BLOCK_HEADER);
     }
 
   FIELD_3DPOINT(base_pt);
-  FIELD(xref_pname, TV);
+  FIELD_TV(xref_pname);
 
   SINCE(R_2000)
     {
 
+#ifdef IS_ENCODER
+      for (vcount = 0; vcount < FIELD_VALUE(insert_count); vcount++)
+        bit_write_RC(dat, 1);
+      bit_write_RC(dat, 0);
+#else
       //skip non-zero bytes and a terminating zero:
       FIELD_VALUE(insert_count)=0;
       while (bit_read_RC(dat))
         {
           FIELD_VALUE(insert_count)++;
         }
+#endif
 
-      FIELD(block_description, TV);
+      FIELD_TV(block_description);
 
       FIELD(size_of_preview_data, BL);
       FIELD_VECTOR(binary_preview_data, RC, size_of_preview_data);
@@ -1763,7 +1810,7 @@ DWG_OBJECT_END
 /*(51)*/
 DWG_OBJECT(LAYER);
 
-  FIELD(entry_name, TV);
+  FIELD_TV(entry_name);
   FIELD(_64_flag, B);
   FIELD(xrefindex_plus1, BS);
   FIELD(xrefdep, B);
@@ -1814,7 +1861,7 @@ DWG_OBJECT_END
 /*(53)*/
 DWG_OBJECT(SHAPEFILE);
 
-  FIELD(entry_name, TV);
+  FIELD_TV(entry_name);
   FIELD(_64_flag, B);
   FIELD(xrefindex_plus1, BS);
   FIELD(xrefdep, B);
@@ -1825,8 +1872,8 @@ DWG_OBJECT(SHAPEFILE);
   FIELD(oblique_ang, BD);
   FIELD(generation, RC);
   FIELD(last_height, BD);
-  FIELD(font_name, TV);
-  FIELD(bigfont_name, TV);
+  FIELD_TV(font_name);
+  FIELD_TV(bigfont_name);
   FIELD_HANDLE(shapefile_control, 4);
   REACTORS(4);
   XDICOBJHANDLE(3);
@@ -1853,11 +1900,11 @@ DWG_OBJECT_END
 DWG_OBJECT(LTYPE);
   char R2007plus_text_area_is_present = 0;
 
-  FIELD(entry_name, TV);
+  FIELD_TV(entry_name);
   FIELD(_64_flag, B);
   FIELD(xrefindex_plus1, BS);
   FIELD(xrefdep, B);
-  FIELD(description, TV);
+  FIELD_TV(description);
   FIELD(pattern_len, BD);
   FIELD(alignment, RC);
   FIELD(num_dashes, RC);
@@ -1911,7 +1958,7 @@ DWG_OBJECT_END
 /*(61)*/
 DWG_OBJECT(VIEW);
 
-  FIELD(entry_name, TV);
+  FIELD_TV(entry_name);
   FIELD(_64_flag, B);
   FIELD(xrefindex_plus1, BS);
   FIELD(xrefdep, B);
@@ -1991,7 +2038,7 @@ DWG_OBJECT_END
 /*(63)*/
 DWG_OBJECT(UCS);
 
-  FIELD(entry_name, TV);
+  FIELD_TV(entry_name);
   FIELD(_64_flag, B);
   FIELD(xrefindex_plus1, BS);
   FIELD(xrefdep, B);
@@ -2359,7 +2406,7 @@ DWG_OBJECT_END
 /*(71)*/
 DWG_OBJECT(VP_ENT_HDR);
 
-  FIELD(entry_name, TV);
+  FIELD_TV(entry_name);
   FIELD(_64_flag, B);
   FIELD(xrefindex_plus1, BS);
   FIELD(xrefdep, B);
@@ -2387,8 +2434,8 @@ DWG_OBJECT_END;
 /*(73)*/
 DWG_OBJECT(MLINESTYLE);
 
-  FIELD(name, TV);
-  FIELD(desc, TV);
+  FIELD_TV(name);
+  FIELD_TV(desc);
   FIELD(flags, BS);
   FIELD_CMC(fillcolor);
   FIELD(startang, BD);
@@ -2517,7 +2564,7 @@ DWG_ENTITY(HATCH);
 
 // TODO: incomplete parsing. check spec. 
 
-DWG_OBJECT_END
+DWG_ENTITY_END
 
 //pg.139
 DWG_OBJECT(IDBUFFER);
@@ -2613,8 +2660,8 @@ DWG_OBJECT_END
 //pg.145
 DWG_OBJECT(LAYOUT);
 
-  FIELD(page_setup_name, TV);
-  FIELD(printer_or_config, TV);
+  FIELD_TV(page_setup_name);
+  FIELD_TV(printer_or_config);
   FIELD(plot_layout_flags, BS);
   FIELD(left_margin, BD);
   FIELD(bottom_margin, BD);
@@ -2622,7 +2669,7 @@ DWG_OBJECT(LAYOUT);
   FIELD(top_margin, BD);
   FIELD(paper_width, BD);
   FIELD(paper_height, BD);
-  FIELD(paper_size, TV);
+  FIELD_TV(paper_size);
   FIELD_2BD(plot_origin);
   FIELD(paper_units, BS);
   FIELD(plot_rotation, BS);
@@ -2632,12 +2679,12 @@ DWG_OBJECT(LAYOUT);
 
   VERSIONS(R_13,R_2000)
     {
-      FIELD(plot_view_name, TV);
+      FIELD_TV(plot_view_name);
     }
 
   FIELD(real_world_units, BD);
   FIELD(drawing_units, BD);
-  FIELD(current_style_sheet, TV);
+  FIELD_TV(current_style_sheet);
   FIELD(scale_type, BS);
   FIELD(scale_factor, BD);
   FIELD_2BD(paper_image_origin);
@@ -2649,7 +2696,7 @@ DWG_OBJECT(LAYOUT);
       FIELD(shade_plot_custom_dpi, BS);
     }
 
-  FIELD(layout_name, TV);
+  FIELD_TV(layout_name);
   FIELD(tab_order, BS);
   FIELD(flags, BS);
   FIELD_3DPOINT(ucs_origin);
@@ -3500,24 +3547,21 @@ DWG_ENTITY_END
 //pg.164
 DWG_OBJECT(XRECORD);
 
-  DECODER
+  FIELD_BL(numdatabytes);
+  FIELD_XDATA(rbuf, numdatabytes);
+
+  SINCE(R_2000)
     {
-	  FIELD_BL(numdatabytes);  	    
-	  FIELD_XDATA(rbuf, numdatabytes);
-	  
-	  SINCE(R_2000)
-		{
-		  FIELD_BS(cloning_flags);
-		}
-	  
-	  FIELD_HANDLE(parent, 3);
-	  REACTORS(4);
-	  XDICOBJHANDLE(3);
-	  
-	  //XXX how to known when I run out of data?
-	  //BITCODE_H* objid_handles;
+      FIELD_BS(cloning_flags);
     }
-    
+
+  FIELD_HANDLE(parent, 3);
+  REACTORS(4);
+  XDICOBJHANDLE(3);
+
+  //XXX how to known when I run out of data?
+  //BITCODE_H* objid_handles;
+
 DWG_OBJECT_END
 
 DWG_OBJECT(PLACEHOLDER);
@@ -26,11 +26,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include "common.h"
 #include "bits.h"
 #include "dwg.h"
 #include "encode.h"
+#include "object.h"
+#include "threads.h"
+
+/* Written for missing references; never changed.  */
+static Dwg_Handle null_handle;
 
 /* The logging level for the write (encode) path.  */
 static unsigned int loglevel;
@@ -164,10 +173,11 @@ bit_write_BE(dat, FIELD_VALUE(name.x), FIELD_VALUE(name.y), FIELD_VALUE(name.z))
     }
 
 #define FIELD_VECTOR(name, type, size) FIELD_VECTOR_N(name, type, _obj->size)
+#define FIELD_VECTOR_T(name, size) FIELD_VECTOR_N(name, TV, _obj->size)
 
-// XXX need a review
+/* A reference that could not be read is written as a null handle.  */
 #define FIELD_HANDLE(name, handle_code) \
-    bit_write_H(dat, &_obj->name->handleref)
+    bit_write_H(dat, _obj->name ? &_obj->name->handleref : &null_handle)
 
 #define HANDLE_VECTOR_N(name, size, code)\
   for (vcount=0; vcount<size; vcount++)\
@@ -177,10 +187,14 @@ bit_write_BE(dat, FIELD_VALUE(name.x), FIELD_VALUE(name.y), FIELD_VALUE(name.z))
 
 #define HANDLE_VECTOR(name, sizefield, code) HANDLE_VECTOR_N(name, FIELD_VALUE(sizefield), code)
 
-#define FIELD_XDATA(name, size)
+#define FIELD_XDATA(name, size)\
+  encode_xdata(dat, dwg, _obj->name, _obj->size)
 
+/* The handles of an entity start here: their offset in bits from the
+   start of the object is patched in as its bitsize, by DWG_ENTITY_END.  */
 #define COMMON_ENTITY_HANDLE_DATA  \
- dwg_encode_common_entity_handle_data(dat, obj);
+  handles_bit = 8 * (dat->byte - object_address) + dat->bit;\
+  dwg_encode_common_entity_handle_data(dat, obj);
 
 #define REPEAT_N(times, name, type) \
   for (rcount=0; rcount<times; rcount++)
@@ -196,15 +210,34 @@ bit_write_BE(dat, FIELD_VALUE(name.x), FIELD_VALUE(name.y), FIELD_VALUE(name.z))
 
 //TODO unify REPEAT macros!
 
+/* The encoders write an object from its type on, at the start of a byte:
+   the type, the common data of entities or objects, then their fields.  */
 #define DWG_ENTITY(token) \
   static void dwg_encode_##token (Bit_Chain * dat, Dwg_Object* obj)	\
 {\
   int vcount, rcount, rcount2, rcount3;\
   Dwg_Data* dwg = obj->parent;\
   Dwg_Entity_##token * _obj = obj->tio.entity->tio.token;\
+  long unsigned int object_address = dat->byte;\
+  long unsigned int handles_bit = 0;\
+  Bit_Chain bitsize_dat;\
   LOG_INFO("Entity " #token ":\n")\
-
-#define DWG_ENTITY_END }
+  bit_write_BS(dat, obj->type);\
+  bitsize_dat = *dat;\
+  dwg_encode_entity(obj, dat);\
+
+/* Since R2000, patch in the bitsize: the offset of the handles, or of
+   the end for the entities whose encoder writes none.  */
+#define DWG_ENTITY_END \
+  SINCE(R_2000)\
+    {\
+      if (!handles_bit)\
+        handles_bit = 8 * (dat->byte - object_address) + dat->bit;\
+      bitsize_dat.chain = dat->chain;\
+      bitsize_dat.size = dat->size;\
+      bit_write_RL(&bitsize_dat, handles_bit);\
+    }\
+}
 
 #define DWG_OBJECT(token) \
   static void dwg_encode_##token (Bit_Chain * dat, Dwg_Object* obj) \
@@ -212,12 +245,13 @@ bit_write_BE(dat, FIELD_VALUE(name.x), FIELD_VALUE(name.y), FIELD_VALUE(name.z))
   int vcount, rcount, rcount2, rcount3;\
   Dwg_Data* dwg = obj->parent; \
   Dwg_Object_##token * _obj = obj->tio.object->tio.token; \
-  LOG_INFO("Entity " #token ":\n")\
+  LOG_INFO("Object " #token ":\n")\
+  bit_write_BS(dat, obj->type);\
+  dwg_encode_object(obj, dat);\
 
 #define DWG_OBJECT_END }
 
 #define ENT_REACTORS(code)\
-  FIELD_VALUE(reactors) = (BITCODE_H*) malloc(sizeof(BITCODE_H) * obj->tio.entity->num_reactors);\
   for (vcount=0; vcount<obj->tio.entity->num_reactors; vcount++)\
     {\
       FIELD_HANDLE(reactors[vcount], code);\
@@ -232,10 +266,497 @@ typedef struct
   unsigned int idc;
 } Object_Map;
 
+static int
+compare_object_map(const void *a, const void *b)
+{
+  const Object_Map *ma = (const Object_Map *) a;
+  const Object_Map *mb = (const Object_Map *) b;
+
+  if (ma->handle != mb->handle)
+    return ma->handle < mb->handle ? -1 : 1;
+  /* Keep duplicates in object order.  */
+  if (ma->idc != mb->idc)
+    return ma->idc < mb->idc ? -1 : 1;
+  return 0;
+}
+
+/* Sort omap by handle.  Objects usually come in handle order, which is
+ * checked first; else the handle index of the decoder gives the order,
+ * if it is still valid for these objects.
+ */
+static void
+sort_object_map(Dwg_Data * dwg, Object_Map * omap)
+{
+  long unsigned int i;
+  Object_Map *sorted;
+
+  for (i = 1; i < dwg->num_objects; i++)
+    if (omap[i].handle < omap[i - 1].handle)
+      break;
+  if (i >= dwg->num_objects)
+    return;
+
+  if (dwg->handle_index && dwg->num_handle_index == dwg->num_objects)
+    {
+      sorted = (Object_Map *) malloc(dwg->num_objects * sizeof(Object_Map));
+      for (i = 0; sorted && i < dwg->num_objects; i++)
+        {
+          sorted[i] = omap[dwg->handle_index[i].index];
+          if ((long unsigned int) sorted[i].handle
+              != dwg->handle_index[i].handle
+              || (i > 0 && sorted[i].handle < sorted[i - 1].handle))
+            break;
+        }
+      if (sorted && i == dwg->num_objects)
+        {
+          memcpy(omap, sorted, dwg->num_objects * sizeof(Object_Map));
+          free(sorted);
+          return;
+        }
+      free(sorted);
+    }
+  qsort(omap, dwg->num_objects, sizeof(Object_Map), compare_object_map);
+}
+
+/* Output of the encoder.  With fd >= 0, the chain is written to fd as it
+ * fills up, and offset is the file offset of its first byte: the chain
+ * then only holds what is still being written, about DWG_STREAM_BUFFER
+ * bytes.  With fd < 0, the whole file is kept in the chain.
+ */
+typedef struct _dwg_stream
+{
+  int fd;
+  long unsigned int offset;
+} Dwg_Stream;
+
+#define DWG_STREAM_BUFFER (1024 * 1024)
+
+static int
+encode_chains(Dwg_Data * dwg, Bit_Chain * dat, Dwg_Stream * out);
+
+/* File offset of the current byte */
+#define ADDRESS(dat) (out->offset + (dat)->byte)
+
+/* Write size bytes at offset of the file open on fd.  */
+static int
+write_at(int fd, const unsigned char *buf, long unsigned int size,
+         long unsigned int offset)
+{
+#ifdef HAVE_UNISTD_H
+  while (size > 0)
+    {
+      ssize_t done = pwrite(fd, buf, size, offset);
+
+      if (done < 0 && errno == EINTR)
+        continue;
+      if (done <= 0)
+        {
+          LOG_ERROR("Could not write to file descriptor %d\n", fd)
+          return -1;
+        }
+      buf += done;
+      size -= done;
+      offset += done;
+    }
+  return 0;
+#else
+  LOG_ERROR("Cannot write to file descriptors here\n")
+  return -1;
+#endif
+}
+
+/* Write the bytes of the chain before the current one to the file, if
+ * there are at least min of them, and slide the rest of the chain down.
+ * The bytes before the current one must be complete: nothing written
+ * there will be patched later.
+ */
+static int
+stream_flush(Bit_Chain * dat, Dwg_Stream * out, long unsigned int min)
+{
+  long unsigned int n = dat->byte;
+
+  if (out->fd < 0 || n == 0 || n < min)
+    return 0;
+  if (write_at(out->fd, dat->chain, n, out->offset))
+    return -1;
+  memmove(dat->chain, dat->chain + n, dat->size - n);
+  memset(dat->chain + dat->size - n, 0, n);
+  dat->byte = 0;
+  out->offset += n;
+  return 0;
+}
+
+/* Estimate the size of the file written from dwg, to reserve it at
+ * once: the objects take about the size they were read with, plus their
+ * size, CRC and map entry, and the other sections are small.
+ */
+static long unsigned int
+estimate_chain_size(Dwg_Data * dwg)
+{
+  long unsigned int i, size = 0x10000 + dwg->unknown1.size;
+
+  for (i = 0; i < dwg->num_objects; i++)
+    size += dwg->object[i].size + 16;
+  return size;
+}
+
+/* Copy the object obj, not decoded by a lazy load, from the chain it
+ * was read from, with its size.
+ */
+static int
+copy_undecoded_object(Dwg_Object * obj, Bit_Chain * dat)
+{
+  Dwg_Data *dwg = obj->parent;
+  Bit_Chain src;
+  long unsigned int size;
+
+  if (!dwg->object_chain || obj->address + 2 > dwg->object_chain_size)
+    {
+      LOG_ERROR("Object %lu was not decoded, and its data is gone\n",
+                obj->handle.value)
+      return -1;
+    }
+  memset(&src, 0, sizeof(src));
+  src.chain = dwg->object_chain;
+  src.size = dwg->object_chain_size;
+  src.byte = obj->address;
+  size = bit_read_MS(&src);
+  size += src.byte - obj->address;
+  if (obj->address + size > dwg->object_chain_size
+      || bit_chain_reserve(dat, size + 2))
+    {
+      LOG_ERROR("Could not copy object %lu\n", obj->handle.value)
+      return -1;
+    }
+  memcpy(&dat->chain[dat->byte], &dwg->object_chain[obj->address], size);
+  dat->byte += size;
+  return 0;
+}
+
+/* Write the CRC of the header variables or the classes, from start to
+ * the current byte of dat.  It is read as a raw short, low byte first,
+ * unlike the CRC bit_write_CRC writes after each object.
+ */
+static void
+write_section_crc(Bit_Chain * dat, long unsigned int start)
+{
+  while (dat->bit > 0)
+    bit_write_B(dat, 0);
+  bit_write_RS(dat, bit_ckr8(0xC0C1, &dat->chain[start], dat->byte - start));
+}
+
+/* Write obj at the current byte of dat, followed by its CRC.  Returns -1
+ * if it cannot be written.
+ */
+static int
+encode_object(Dwg_Object * obj, Bit_Chain * dat)
+{
+  long unsigned int address = dat->byte;
+
+  if (obj->supertype == DWG_SUPERTYPE_UNKNOWN)
+    {
+      bit_write_MS(dat, obj->size);
+      if (bit_chain_reserve(dat, obj->size + 2))
+        {
+          LOG_ERROR("Could not copy object %lu\n", obj->handle.value)
+          return -1;
+        }
+      memcpy(&dat->chain[dat->byte], obj->tio.unknown, obj->size);
+      dat->byte += obj->size;
+    }
+  else if (obj->supertype == DWG_SUPERTYPE_UNDECODED)
+    {
+      if (copy_undecoded_object(obj, dat))
+        return -1;
+    }
+  else if (obj->supertype == DWG_SUPERTYPE_ENTITY
+           || obj->supertype == DWG_SUPERTYPE_OBJECT)
+    {
+      if (dwg_encode_add_object(obj, dat, dat->byte))
+        return -1;
+    }
+  else
+    {
+      LOG_ERROR("Error: undefined (super)type of object\n");
+      return -1;
+    }
+  bit_write_CRC(dat, address, 0xC0C1);
+  return 0;
+}
+
+/* The objects are encoded on several threads in runs of up to this many,
+ * and this many runs per thread at a time, so that the threads finishing
+ * early can take over the rest.  */
+#define OBJECTS_PER_CHUNK 1024
+#define CHUNKS_PER_THREAD 4
+
+/* A run of objects of the object map, encoded one after the other into a
+ * chain of its own.  Until the chain is appended to the output, the
+ * addresses of the objects in the map are their offsets in it.
+ */
+typedef struct _encode_chunk
+{
+  long unsigned int first;
+  long unsigned int last;
+  Bit_Chain dat;
+  int error;
+} Encode_Chunk;
+
+typedef struct _encode_run
+{
+  Dwg_Data *dwg;
+  Object_Map *omap;
+  Encode_Chunk *chunk;
+} Encode_Run;
+
+/* Task encoding chunk i from the start of its chain.
+ */
+static void
+encode_chunk(void *data, unsigned int i)
+{
+  Encode_Run *run = (Encode_Run *) data;
+  Encode_Chunk *chunk = &run->chunk[i];
+  Dwg_Object *obj;
+  long unsigned int j, size = 0;
+
+  chunk->dat.byte = 0;
+  chunk->dat.bit = 0;
+  for (j = chunk->first; j < chunk->last; j++)
+    size += run->dwg->object[run->omap[j].idc].size + 16;
+  if (bit_chain_reserve(&chunk->dat, size))
+    {
+      chunk->error = -1;
+      return;
+    }
+  for (j = chunk->first; j < chunk->last; j++)
+    {
+      obj = &run->dwg->object[run->omap[j].idc];
+      run->omap[j].address = chunk->dat.byte;
+      if (encode_object(obj, &chunk->dat))
+        {
+          chunk->error = -1;
+          return;
+        }
+    }
+}
+
+/* Write the objects in the order of omap, with their CRCs, and record
+ * their addresses in it.  With DWG_OPT_THREADS, they are encoded on
+ * several threads, a window of chunks at a time, and the chunks are then
+ * appended to dat in order: the file is the same.  Returns -1 if out of
+ * memory or if the output cannot be written.
+ */
+static int
+encode_objects(Dwg_Data * dwg, Bit_Chain * dat, Dwg_Stream * out,
+               Object_Map * omap)
+{
+  Encode_Run run;
+  unsigned int i, num_threads, num_chunks, max_chunks;
+  long unsigned int j, next, per_chunk, base;
+  int error = 0;
+
+  num_threads = dwg_num_threads(dwg);
+  if (num_threads > dwg->num_objects / 16)
+    num_threads = dwg->num_objects / 16;
+  max_chunks = num_threads * CHUNKS_PER_THREAD;
+  run.chunk = 0;
+  if (num_threads > 1)
+    run.chunk = (Encode_Chunk *) calloc(max_chunks, sizeof(Encode_Chunk));
+
+  if (!run.chunk)
+    {
+      for (j = 0; j < dwg->num_objects; j++)
+        {
+          omap[j].address = ADDRESS(dat);
+          if (encode_object(&dwg->object[omap[j].idc], dat)
+              || stream_flush(dat, out, DWG_STREAM_BUFFER))
+            return -1;
+        }
+      return 0;
+    }
+
+  per_chunk = (dwg->num_objects + max_chunks - 1) / max_chunks;
+  if (per_chunk > OBJECTS_PER_CHUNK)
+    per_chunk = OBJECTS_PER_CHUNK;
+  for (i = 0; i < max_chunks; i++)
+    run.chunk[i].dat.version = dat->version;
+  run.dwg = dwg;
+  run.omap = omap;
+
+  for (next = 0; !error && next < dwg->num_objects;)
+    {
+      for (i = 0; i < max_chunks && next < dwg->num_objects; i++)
+        {
+          run.chunk[i].first = next;
+          next += per_chunk;
+          if (next > dwg->num_objects)
+            next = dwg->num_objects;
+          run.chunk[i].last = next;
+        }
+      num_chunks = i;
+      if (dwg_run_tasks(encode_chunk, &run, num_chunks, num_threads))
+        error = -1;
+
+      for (i = 0; !error && i < num_chunks; i++)
+        {
+          Encode_Chunk *chunk = &run.chunk[i];
+
+          if (chunk->error)
+            {
+              error = -1;
+              break;
+            }
+          if (bit_chain_reserve(dat, chunk->dat.byte))
+            {
+              LOG_ERROR("Out of memory\n")
+              error = -1;
+              break;
+            }
+          base = ADDRESS(dat);
+          for (j = chunk->first; j < chunk->last; j++)
+            omap[j].address += base;
+          memcpy(&dat->chain[dat->byte], chunk->dat.chain, chunk->dat.byte);
+          dat->byte += chunk->dat.byte;
+          if (stream_flush(dat, out, DWG_STREAM_BUFFER))
+            error = -1;
+        }
+    }
+
+  for (i = 0; i < max_chunks; i++)
+    free(run.chunk[i].dat.chain);
+  free(run.chunk);
+  return error;
+}
+
+/* Write the xdata rbuf as dwg_decode_xdata reads it back, in the size
+ * bytes it was read from.  Strings are written in the codepage of the
+ * drawing, the one they were read in being unknown.
+ */
+static void
+encode_xdata(Bit_Chain * dat, Dwg_Data * dwg, Dwg_Resbuf * rbuf,
+             long unsigned int size)
+{
+  long unsigned int start = dat->byte;
+  int i, length;
+
+  for (; rbuf; rbuf = rbuf->next)
+    {
+      bit_write_RS(dat, rbuf->type);
+      switch (get_base_value_type(rbuf->type))
+        {
+        case VT_STRING:
+          length = rbuf->value.str ? strlen(rbuf->value.str) : 0;
+          bit_write_RS(dat, length);
+          bit_write_RC(dat, dwg->header.codepage);
+          for (i = 0; i < length; i++)
+            bit_write_RC(dat, rbuf->value.str[i]);
+          break;
+        case VT_REAL:
+          bit_write_RD(dat, rbuf->value.dbl);
+          break;
+        case VT_BOOL:
+        case VT_INT8:
+          bit_write_RC(dat, rbuf->value.i8);
+          break;
+        case VT_INT16:
+          bit_write_RS(dat, rbuf->value.i16);
+          break;
+        case VT_INT32:
+          bit_write_RL(dat, rbuf->value.i32);
+          break;
+        case VT_POINT3D:
+          bit_write_RD(dat, rbuf->value.pt[0]);
+          bit_write_RD(dat, rbuf->value.pt[1]);
+          bit_write_RD(dat, rbuf->value.pt[2]);
+          break;
+        case VT_BINARY:
+          bit_write_RC(dat, rbuf->value.chunk.size);
+          for (i = 0; i < rbuf->value.chunk.size; i++)
+            bit_write_RC(dat, rbuf->value.chunk.data[i]);
+          break;
+        case VT_HANDLE:
+        case VT_OBJECTID:
+          for (i = 0; i < 8; i++)
+            bit_write_RC(dat, rbuf->value.hdl[i]);
+          break;
+        default:
+          break;
+        }
+    }
+  if (dat->byte - start != size)
+    LOG_ERROR("xdata of %lu bytes written in %lu\n", size,
+              dat->byte - start)
+}
+
 #include "dwg.spec"
 
+typedef struct _class_encoder
+{
+  const char *dxfname;
+  Dwg_Object_Decoder encode;
+} Class_Encoder;
+
+#define CLASS_ENCODER(dxfname, token) { dxfname, dwg_encode_##token },
+
+/* Encoders of the objects of variable type, by class DXF name: those of
+ * the classes the decoder has.
+ */
+static const Class_Encoder dwg_class_encoders[] =
+{
+  CLASS_DECODERS(CLASS_ENCODER)
+};
+
+/* Return the encoder of obj, of variable type, from the DXF name of its
+ * class, or NULL if there is none.
+ */
+static Dwg_Object_Decoder
+class_encoder(Dwg_Object * obj)
+{
+  Dwg_Data *dwg = obj->parent;
+  const char *dxfname;
+  unsigned int i;
+
+  if (obj->type < 500 || obj->type - 500 >= dwg->num_classes)
+    return 0;
+  dxfname = (const char *) dwg->dwg_class[obj->type - 500].dxfname;
+  if (!dxfname)
+    return 0;
+  for (i = 0; i < sizeof(dwg_class_encoders) / sizeof(dwg_class_encoders[0]);
+       i++)
+    if (!strcmp(dxfname, dwg_class_encoders[i].dxfname))
+      return dwg_class_encoders[i].encode;
+  return 0;
+}
+
 int
 dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
+{
+  Dwg_Stream out = { -1, 0 };
+
+  return encode_chains(dwg, dat, &out);
+}
+
+/* Encode dwg straight to the file open on fd, through a chain of about
+ * DWG_STREAM_BUFFER bytes.  The sizes and addresses known only at the
+ * end, in the file header, are written there last, so fd must allow
+ * pwrite: it must be a regular file.
+ */
+int
+dwg_encode_fd(Dwg_Data * dwg, int fd)
+{
+  Dwg_Stream out = { fd, 0 };
+  Bit_Chain dat;
+  int error;
+
+  memset(&dat, 0, sizeof(dat));
+  dat.version = (Dwg_Version_Type) dwg->header.version;
+  error = encode_chains(dwg, &dat, &out);
+  free(dat.chain);
+  return error;
+}
+
+static int
+encode_chains(Dwg_Data * dwg, Bit_Chain * dat, Dwg_Stream * out)
 {
   int ckr_missing;
   long unsigned int i, j;
@@ -248,8 +769,8 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
   long unsigned int last_address;
   long unsigned int last_handle;
   Object_Map *omap;
-  Object_Map pvzmap;
-  Dwg_Object *obj;
+  Bit_Chain head;
+  unsigned char header[0x80];
 
   #ifdef USE_TRACING
   /* Before starting, set the logging level, but only do so once.  */
@@ -264,6 +785,12 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
   #endif  /* USE_TRACING */
 
   bit_chain_alloc(dat);
+  if (bit_chain_reserve(dat, out->fd < 0 ? estimate_chain_size(dwg)
+                        : 2 * DWG_STREAM_BUFFER))
+    {
+      LOG_ERROR("Out of memory\n")
+      return -1;
+    }
 
   /*------------------------------------------------------------
    * Header
@@ -301,8 +828,11 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
 
       dwg->unknown1.size = dwg->header.section[5].size;
       dwg->unknown1.byte = dwg->unknown1.bit = 0;
-      while (dat->byte + dwg->unknown1.size >= dat->size)
-        bit_chain_alloc(dat);
+      if (bit_chain_reserve(dat, dwg->unknown1.size))
+        {
+          LOG_ERROR("Out of memory\n")
+          return -1;
+        }
       memcpy(&dat->chain[dat->byte], dwg->unknown1.chain, dwg->unknown1.size);
       dat->byte += dwg->unknown1.size;
 
@@ -333,12 +863,24 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
     }
   bit_write_sentinel(dat, dwg_sentinel(DWG_SENTINEL_PICTURE_END));
 
+  /* Keep the file header, to write the section addresses in it at the
+     end, once it is out of the chain.  */
+  if (section_address + dwg->header.num_sections * 9 + 2 > sizeof(header))
+    {
+      LOG_ERROR("Too many sections: %lu\n", dwg->header.num_sections)
+      return -1;
+    }
+  memcpy(header, dat->chain, section_address
+         + dwg->header.num_sections * 9 + 2);
+  if (stream_flush(dat, out, DWG_STREAM_BUFFER))
+    goto write_error;
+
   /*------------------------------------------------------------
    * Header Variables
    */
 
   dwg->header.section[0].number = 0;
-  dwg->header.section[0].address = dat->byte;
+  dwg->header.section[0].address = ADDRESS(dat);
   bit_write_sentinel(dat, dwg_sentinel(DWG_SENTINEL_VARIABLE_BEGIN));
   pvzadr = dat->byte; // Afterwards one must rewrite the correct values of size here
 
@@ -360,19 +902,18 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
 
   /* CRC and sentinel
    */
-  bit_write_CRC(dat, pvzadr, 0xC0C1);
-
-  //XXX trying to fix CRC 2-byte overflow. Must find actual reason
-  dat->byte -= 2;
+  write_section_crc(dat, pvzadr);
 
   bit_write_sentinel(dat, dwg_sentinel(DWG_SENTINEL_VARIABLE_END));
-  dwg->header.section[0].size = dat->byte - dwg->header.section[0].address;
+  dwg->header.section[0].size = ADDRESS(dat) - dwg->header.section[0].address;
+  if (stream_flush(dat, out, DWG_STREAM_BUFFER))
+    goto write_error;
 
   /*------------------------------------------------------------
    * Classes
    */
   dwg->header.section[1].number = 1;
-  dwg->header.section[1].address = dat->byte;
+  dwg->header.section[1].address = ADDRESS(dat);
   bit_write_sentinel(dat, dwg_sentinel(DWG_SENTINEL_CLASS_BEGIN));
   pvzadr = dat->byte; // Afterwards one must rewrite the correct values of size here
   bit_write_RL(dat, 0); // Size of the section
@@ -401,10 +942,10 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
 
   /* CRC and sentinel
    */
-  bit_write_CRC(dat, pvzadr, 0xC0C1);
+  write_section_crc(dat, pvzadr);
 
   bit_write_sentinel(dat, dwg_sentinel(DWG_SENTINEL_CLASS_END));
-  dwg->header.section[1].size = dat->byte - dwg->header.section[1].address;
+  dwg->header.section[1].size = ADDRESS(dat) - dwg->header.section[1].address;
 
   bit_write_RL(dat, 0x00000000); // 0xDCA Unknown bitlong inter class and objects
 
@@ -428,6 +969,8 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
         omap[i].handle = dwg->object[i].handle.value;
       else if (dwg->object[i].supertype == DWG_SUPERTYPE_OBJECT)
         omap[i].handle = dwg->object[i].handle.value;
+      else if (dwg->object[i].supertype == DWG_SUPERTYPE_UNDECODED)
+        omap[i].handle = dwg->object[i].handle.value;
       else if (dwg->object[i].supertype == DWG_SUPERTYPE_UNKNOWN)
         {
           nkn.chain = dwg->object[i].tio.unknown;
@@ -440,60 +983,18 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
         }
       else
         omap[i].handle = 0x7FFFFFFF; /* Error! */
-
-      /* Arrange the sequence of handles according to a growing order  */
-      if (i > 0)
-        {
-          j = i;
-          while (omap[j].handle < omap[j - 1].handle)
-            {
-              omap[j - 1].handle = pvzmap.handle;
-              omap[j - 1].idc = pvzmap.idc;
-
-              omap[j - 1].handle = omap[j].handle;
-              omap[j - 1].idc = omap[j].idc;
-
-              omap[j].handle = pvzmap.handle;
-              omap[j].idc = pvzmap.idc;
-              j--;
-              if (j == 0)
-                break;
-            }
-        }
     }
+
+  /* Arrange the sequence of handles according to a growing order  */
+  sort_object_map(dwg, omap);
   //for (i = 0; i < dwg->num_objects; i++) printf ("Handle(%i): %lu / Idc: %u\n", i, omap[i].handle, omap[i].idc);
 
   /* Write the objects
    */
-  for (i = 0; i < dwg->num_objects; i++)
+  if (encode_objects(dwg, dat, out, omap))
     {
-      omap[i].address = dat->byte;
-      obj = &dwg->object[omap[i].idc];
-      if (obj->supertype == DWG_SUPERTYPE_UNKNOWN)
-        {
-          bit_write_MS(dat, obj->size);
-          if (dat->byte + obj->size >= dat->size - 2)
-            bit_chain_alloc(dat);
-          memcpy(&dat->chain[dat->byte], obj->tio.unknown, obj->size);
-          dat->byte += obj->size;
-        }
-      else
-        {
-	  if (obj->supertype == DWG_SUPERTYPE_ENTITY || obj->supertype == DWG_SUPERTYPE_OBJECT)
-	    dwg_encode_add_object(obj, dat, dat->byte);
-	  /*
-          if (obj->supertype == DWG_SUPERTYPE_ENTITY)
-            dwg_encode_entity(obj, dat);
-          else if (obj->supertype == DWG_SUPERTYPE_OBJECT)
-            dwg_encode_object(obj, dat);
-	  */
-          else
-            {
-              LOG_ERROR("Error: undefined (super)type of object\n");
-              exit(-1);
-            }
-        }
-      bit_write_CRC(dat, omap[i].address, 0xC0C1);
+      free(omap);
+      goto write_error;
     }
     for (i = 0; i < dwg->num_objects; i++) 
       LOG_INFO ("Object(%i): %6lu / Address: %08X / Idc: %u\n", 
@@ -507,7 +1008,7 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
    * Object-map
    */
   dwg->header.section[2].number = 2;
-  dwg->header.section[2].address = dat->byte; // Value of size should be calculated later
+  dwg->header.section[2].address = ADDRESS(dat); // Value of size should be calculated later
   //printf ("Begin: 0x%08X\n", dat->byte);
 
   sekcisize = 0;
@@ -517,20 +1018,17 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
   last_handle = 0;
   for (i = 0; i < dwg->num_objects; i++)
     {
-      unsigned int idc;
       long int pvz;
 
-      idc = omap[i].idc;
-
-      pvz = omap[idc].handle - last_handle;
+      pvz = omap[i].handle - last_handle;
       bit_write_MC(dat, pvz);
       //printf ("Handle(%i): %6lu / ", i, pvz);
-      last_handle = omap[idc].handle;
+      last_handle = omap[i].handle;
 
-      pvz = omap[idc].address - last_address;
+      pvz = omap[i].address - last_address;
       bit_write_MC(dat, pvz);
       //printf ("Address: %08X\n", pvz);
-      last_address = omap[idc].address;
+      last_address = omap[i].address;
 
 
       //dwg dwg_encode_add_object(dwg->object[i], dat, last_address);
@@ -544,6 +1042,11 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
           dat->chain[pvzadr + 1] = sekcisize & 0xFF;
           bit_write_CRC(dat, pvzadr, 0xC0C1);
 
+          if (stream_flush(dat, out, DWG_STREAM_BUFFER))
+            {
+              free(omap);
+              goto write_error;
+            }
           pvzadr = dat->byte;
           dat->byte += 2;
           last_address = 0;
@@ -565,7 +1068,7 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
 
   /* Calculate and write the size of the object map
    */
-  dwg->header.section[2].size = dat->byte - dwg->header.section[2].address;
+  dwg->header.section[2].size = ADDRESS(dat) - dwg->header.section[2].address;
   free(omap);
 
   /*------------------------------------------------------------
@@ -576,7 +1079,7 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
   pvzadr = dat->byte; // Keep the first address of the section to write its size later
   bit_write_RL(dat, 0);
 
-  bit_write_BL(dat, pvzadr - 16); // start_address of the section
+  bit_write_BL(dat, out->offset + pvzadr - 16); // start_address of the section
 
   /* Version Code
    */
@@ -647,78 +1150,88 @@ dwg_encode_chains(Dwg_Data * dwg, Bit_Chain * dat)
   dwg->header.section[3].address = 0;
   dwg->header.section[3].size = 0;
   dwg->header.section[4].number = 4;
-  dwg->header.section[4].address = dat->byte;
+  dwg->header.section[4].address = ADDRESS(dat);
   dwg->header.section[4].size = 4;
   bit_write_RL(dat, dwg->measurement);
 
   /* End of the file
    */
+  if (stream_flush(dat, out, 0))
+    goto write_error;
   dat->size = dat->byte;
 
-  /* Write section addresses
+  /* Write section addresses, in the chain if the file header is still
+     there, else in its copy, written back to the file.
    */
-  dat->byte = section_address;
-  dat->bit = 0;
+  head.chain = header;
+  head.size = sizeof(header);
+  head.version = dat->version;
+  head.byte = section_address;
+  head.bit = 0;
   for (i = 0; i < dwg->header.num_sections; i++)
     {
-      bit_write_RC(dat, dwg->header.section[i].number);
-      bit_write_RL(dat, dwg->header.section[i].address);
-      bit_write_RL(dat, dwg->header.section[i].size);
+      bit_write_RC(&head, dwg->header.section[i].number);
+      bit_write_RL(&head, dwg->header.section[i].address);
+      bit_write_RL(&head, dwg->header.section[i].size);
     }
 
   /* Write CRC's
    */
-  bit_write_CRC(dat, 0, 0);
-  dat->byte -= 2;
-  ckr = bit_read_CRC(dat);
-  dat->byte -= 2;
+  bit_write_CRC(&head, 0, 0);
+  head.byte -= 2;
+  ckr = bit_read_CRC(&head);
+  head.byte -= 2;
   switch (dwg->header.num_sections)
     {
   case 3:
-    bit_write_RS(dat, ckr ^ 0xA598);
+    bit_write_RS(&head, ckr ^ 0xA598);
     break;
   case 4:
-    bit_write_RS(dat, ckr ^ 0x8101);
+    bit_write_RS(&head, ckr ^ 0x8101);
     break;
   case 5:
-    bit_write_RS(dat, ckr ^ 0x3CC4);
+    bit_write_RS(&head, ckr ^ 0x3CC4);
     break;
   case 6:
-    bit_write_RS(dat, ckr ^ 0x8461);
+    bit_write_RS(&head, ckr ^ 0x8461);
     break;
   default:
-    bit_write_RS(dat, ckr);
+    bit_write_RS(&head, ckr);
     }
 
+  if (out->fd < 0)
+    memcpy(dat->chain, header, head.byte);
+  else if (write_at(out->fd, header, head.byte, 0))
+    return -1;
   return 0;
+
+ write_error:
+  return -1;
 }
 
-void
+/* Write obj at address of dat, which is left after it: its size, then
+ * the object.  The size is that of the object as written, patched in
+ * once known.  An object of a type with no encoder is copied as it was
+ * read, if the chain it was read from is still there.  Returns -1 if
+ * obj cannot be written.
+ */
+int
 dwg_encode_add_object(Dwg_Object * obj, Bit_Chain * dat,
     long unsigned int address)
 {
-  long unsigned int previous_address;
   long unsigned int object_address;
-  unsigned char previous_bit;
-
-  /* Keep the previous address
-   */
-  previous_address = dat->byte;
-  previous_bit = dat->bit;
+  Bit_Chain size_dat;
+  Dwg_Object_Decoder encode;
 
-  /* Use the indicated address for the object
-   */
   dat->byte = address;
   dat->bit = 0;
 
       LOG_INFO("\n\n======================\nObject number: %lu",
           obj->index)
 
+  size_dat = *dat;
   bit_write_MS(dat, obj->size);
   object_address = dat->byte;
-  //  ktl_lastaddress = dat->byte + obj->size; /* (calculate the bitsize) */
-  
-  bit_write_BS(dat, obj->type);
 
   LOG_INFO(" Type: %d\n", obj->type)
 
@@ -943,60 +1456,66 @@ dwg_encode_add_object(Dwg_Object * obj, Bit_Chain * dat,
     dwg_encode_LAYOUT(dat, obj);
     break;
   default:
-    if (0)//!dwg_encode_variable_type(dwg, dat, obj))
+    encode = class_encoder(obj);
+    if (encode)
+      encode(dat, obj);
+    else
       {
-        LOG_INFO("Object UNKNOWN:\n")
-
-        SINCE(R_2000)
+        /* Not even its size is written yet.  */
+        dat->byte = address;
+        if (copy_undecoded_object(obj, dat))
           {
-            bit_read_RL(dat);  // skip bitsize
+            LOG_ERROR("Objects of type %d cannot be encoded yet\n",
+                      obj->type)
+            return -1;
           }
-
-        if (!bit_read_H(dat, &obj->handle))
-          {
-            LOG_INFO("Object handle: %x.%x.%lx\n", 
-              obj->handle.code, obj->handle.size, obj->handle.value)
-          }
-
-        obj->supertype = DWG_SUPERTYPE_UNKNOWN;
-        obj->tio.unknown = (unsigned char*)malloc(obj->size);
-        memcpy(obj->tio.unknown, &dat->chain[object_address], obj->size);
+        return 0;
       }
     }
 
-  /*
-   if (obj->supertype != DWG_SUPERTYPE_UNKNOWN)
-   {
-   fprintf (stderr, " Begin address:\t%10lu\n", address);
-   fprintf (stderr, " Last address:\t%10lu\tSize: %10lu\n", dat->byte, obj->size);
-   fprintf (stderr, "End address:\t%10lu (calculated)\n", address + 2 + obj->size);
-   }
-   */
+  /* The size of the object is in whole bytes.  */
+  while (dat->bit)
+    bit_write_B(dat, 0);
+  size_dat.chain = dat->chain;
+  size_dat.size = dat->size;
+  bit_write_MS(&size_dat, dat->byte - object_address);
+  return 0;
+}
 
-  /* Register the previous addresses for return
-   */
-  dat->byte = previous_address;
-  dat->bit = previous_bit;
+/* Write the extended data read as one block with its handle, and the
+ * size 0 ending it.
+ */
+static void
+encode_extended_data(Bit_Chain * dat, unsigned int size,
+                     Dwg_Handle * handle, const unsigned char *data)
+{
+  unsigned int i;
+
+  if (size)
+    {
+      bit_write_BS(dat, size);
+      bit_write_H(dat, handle);
+      for (i = 0; i < size; i++)
+        bit_write_RC(dat, data[i]);
+    }
+  bit_write_BS(dat, 0);
 }
 
 void
 dwg_encode_entity(Dwg_Object * obj, Bit_Chain * dat)
 {
-  //XXX not sure about this, someone should review
-  unsigned int size;
-  unsigned int extended_size;
   int i;
-  
-  size =  obj->tio.entity->bitsize;
-  bit_write_RL(dat, size);
+
+  /* Patched in with the offset of the handles, by DWG_ENTITY_END.  */
+  SINCE(R_2000)
+    {
+      bit_write_RL(dat, obj->tio.entity->bitsize);
+    }
   bit_write_H(dat, &(obj->handle));
-  extended_size = obj->tio.entity->extended_size;
-  bit_write_BS(dat, extended_size);
-  bit_write_H(dat, &(obj->tio.entity->extended_handle));
-  
-  for(i = extended_size - size; i< extended_size; i++)
-    bit_write_RC(dat, obj->tio.entity->extended[i]);
-    
+  encode_extended_data(dat, obj->tio.entity->extended_size,
+                       &obj->tio.entity->extended_handle,
+                       (unsigned char *) obj->tio.entity->extended);
+
   bit_write_B(dat, obj->tio.entity->picture_exists);
   if (obj->tio.entity->picture_exists)
     {
@@ -1064,19 +1583,15 @@ dwg_encode_entity(Dwg_Object * obj, Bit_Chain * dat)
 void
 dwg_encode_common_entity_handle_data(Bit_Chain * dat, Dwg_Object * obj)
 {
-  //XXX: not sure about this
-  
   //setup required to use macros
   Dwg_Object_Entity *ent;
   Dwg_Data *dwg = obj->parent;
-  int i;
   long unsigned int vcount;
   Dwg_Object_Entity *_obj;
   ent = obj->tio.entity;
   _obj = ent;
 
-  //#include "common_entity_handle_data.spec"
-  
+  #include "common_entity_handle_data.spec"
 }
 
 void
@@ -1110,13 +1625,8 @@ dwg_encode_object(Dwg_Object * obj, Bit_Chain * dat)
     }
 
   bit_write_H(dat, &ord->object->handle);
-  
-  bit_write_BS(dat, obj->size);
-  bit_write_H(dat, &ord->extended_handle);
-  
-  for (i = ord->extended_size - obj->size; i < ord->extended_size; i++)
-         bit_write_RC(dat, ord->extended[i]);
-    
+  encode_extended_data(dat, ord->extended_size, &ord->extended_handle,
+                       ord->extended);
 
   VERSIONS(R_13,R_14)
     {
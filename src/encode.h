@@ -26,12 +26,18 @@
 int
 dwg_encode_chains(Dwg_Data * dwg_struct, Bit_Chain * bitaro);
 
+int
+dwg_encode_fd(Dwg_Data * dwg, int fd);
+
 void
 dwg_encode_entity(Dwg_Object * obj, Bit_Chain * dat);
 
 void
 dwg_encode_object(Dwg_Object * obj, Bit_Chain * dat);
 
+void
+dwg_encode_common_entity_handle_data(Bit_Chain * dat, Dwg_Object * obj);
+
 void
 dwg_encode_header_variables(Bit_Chain* dat, Dwg_Data * dwg);
 
@@ -43,7 +49,7 @@ void
 dwg_encode_handleref_with_code(Bit_Chain * dat, Dwg_Object * obj,
                                Dwg_Data* dwg, Dwg_Object_Ref* ref, int code);
 
-void
+int
 dwg_encode_add_object(Dwg_Object * obj, Bit_Chain * dat,
                       long unsigned int address);
 
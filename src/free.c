@@ -0,0 +1,300 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * free.c: release the memory of decoded objects
+ *
+ * The free functions are generated from dwg.spec like the decoder, and
+ * walk the same fields in the same order, releasing whatever the decoder
+ * allocated for them.  Handle references are not released here: every
+ * one of them is also in dwg->object_ref, and is freed from there.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "bits.h"
+#include "dwg.h"
+#include "free.h"
+#include "object.h"
+
+#include "logging.h"
+
+/*--------------------------------------------------------------------------------
+ * MACROS
+ */
+
+#define IS_FREE
+
+#define FREE_IF(ptr) free(ptr); ptr = 0
+
+#define FIELD(name,type)
+
+#define FIELD_VALUE(name) _obj->name
+
+#define ANYCODE -1
+#define FIELD_HANDLE(name, handle_code)
+
+#define FIELD_B(name)
+#define FIELD_BB(name)
+#define FIELD_BS(name)
+#define FIELD_BL(name)
+#define FIELD_BD(name)
+#define FIELD_RC(name)
+#define FIELD_RS(name)
+#define FIELD_RD(name)
+#define FIELD_RL(name)
+#define FIELD_MC(name)
+#define FIELD_MS(name)
+#define FIELD_TV(name) FREE_IF(_obj->name);
+#define FIELD_T FIELD_TV /*TODO: implement version dependant string fields */
+#define FIELD_BT(name)
+#define FIELD_4BITS(name)
+#define FIELD_BE(name)
+#define FIELD_DD(name, _default)
+#define FIELD_2DD(name, d1, d2)
+#define FIELD_2RD(name)
+#define FIELD_2BD(name)
+#define FIELD_3RD(name)
+#define FIELD_3BD(name)
+#define FIELD_3DPOINT(name)
+#define FIELD_CMC(color)\
+  SINCE(R_2004)\
+    {\
+      if (_obj->color.byte & 1)\
+        {\
+          FREE_IF(_obj->color.name);\
+        }\
+      if (_obj->color.byte & 2)\
+        {\
+          FREE_IF(_obj->color.book_name);\
+        }\
+    }
+
+#define FIELD_VECTOR_N(name, type, size) FREE_IF(_obj->name);
+#define FIELD_VECTOR(name, type, size) FREE_IF(_obj->name);
+
+#define FIELD_VECTOR_T(name, size)\
+  if (_obj->name)\
+    {\
+      for (vcount=0; vcount< _obj->size; vcount++)\
+        free(_obj->name[vcount]);\
+      FREE_IF(_obj->name);\
+    }
+
+#define FIELD_2RD_VECTOR(name, size) FREE_IF(_obj->name);
+#define FIELD_2DD_VECTOR(name, size) FREE_IF(_obj->name);
+#define FIELD_3DPOINT_VECTOR(name, size) FREE_IF(_obj->name);
+
+#define HANDLE_VECTOR_N(name, size, code) FREE_IF(FIELD_VALUE(name));
+#define HANDLE_VECTOR(name, sizefield, code) HANDLE_VECTOR_N(name, FIELD_VALUE(sizefield), code)
+
+#define FIELD_XDATA(name, size)\
+  dwg_free_xdata(_obj->name);\
+  _obj->name = 0
+
+#define REACTORS(code) FREE_IF(FIELD_VALUE(reactors));
+#define ENT_REACTORS(code) FREE_IF(FIELD_VALUE(reactors));
+
+#define XDICOBJHANDLE(code)
+#define ENT_XDICOBJHANDLE(code)
+
+/* The body of a REPEAT releases the fields of each element, and the
+ * vector itself goes on the extra, last pass of the loop.
+ */
+#define REPEAT_N(times, name, type) \
+  for (rcount=0; _obj->name && rcount<=(times); rcount++)\
+    if (rcount == (times))\
+      {\
+        FREE_IF(_obj->name);\
+      }\
+    else
+
+#define REPEAT(times, name, type) REPEAT_N(_obj->times, name, type)
+
+#define REPEAT2(times, name, type) \
+  for (rcount2=0; _obj->name && rcount2<=_obj->times; rcount2++)\
+    if (rcount2 == _obj->times)\
+      {\
+        FREE_IF(_obj->name);\
+      }\
+    else
+
+#define REPEAT3(times, name, type) \
+  for (rcount3=0; _obj->name && rcount3<=_obj->times; rcount3++)\
+    if (rcount3 == _obj->times)\
+      {\
+        FREE_IF(_obj->name);\
+      }\
+    else
+
+#define COMMON_ENTITY_HANDLE_DATA /*  Empty */
+
+/* Every spec gets a free function, though no object has the types that
+ * are not decoded (UNUSED, PROXY, TABLE), and most have nothing to
+ * repeat or to release.
+ */
+#ifdef __GNUC__
+#define FREE_UNUSED __attribute__ ((unused))
+#else
+#define FREE_UNUSED
+#endif
+
+#define DWG_ENTITY(token) \
+static void FREE_UNUSED \
+dwg_free_##token (Bit_Chain * dat, Dwg_Object * obj)\
+{\
+  int vcount FREE_UNUSED, rcount FREE_UNUSED;\
+  int rcount2 FREE_UNUSED, rcount3 FREE_UNUSED;\
+  Dwg_Entity_##token *ent, *_obj FREE_UNUSED;\
+  ent = obj->tio.entity->tio.token;\
+  _obj=ent;
+
+#define DWG_ENTITY_END }
+
+#define DWG_OBJECT(token) \
+static void FREE_UNUSED \
+dwg_free_ ##token (Bit_Chain * dat, Dwg_Object * obj) \
+{ \
+  int vcount FREE_UNUSED, rcount FREE_UNUSED;\
+  int rcount2 FREE_UNUSED, rcount3 FREE_UNUSED;\
+  Dwg_Object_##token *_obj FREE_UNUSED;\
+  _obj = obj->tio.object->tio.token;
+
+#define DWG_OBJECT_END }
+
+#include "dwg.spec"
+
+typedef struct _class_free
+{
+  const char *dxfname;
+  Dwg_Object_Decoder free;
+} Class_Free;
+
+#define FIXED_FREE(type, token) [type] = dwg_free_##token,
+#define CLASS_FREE(dxfname, token) { dxfname, dwg_free_##token },
+
+/* Free functions of the objects of fixed type, indexed by type, for the
+ * types the decoder has.
+ */
+static const Dwg_Object_Decoder dwg_fixed_free[DWG_TYPE_LAYOUT + 1] =
+{
+  FIXED_DECODERS(FIXED_FREE)
+};
+
+/* Free functions of the objects of variable type, by class DXF name.
+ */
+static const Class_Free dwg_class_free[] =
+{
+  CLASS_DECODERS(CLASS_FREE)
+};
+
+/* Release the header variables of dwg.
+ */
+void
+dwg_free_header_vars(Dwg_Data *dwg)
+{
+  Bit_Chain chain;
+  Bit_Chain *dat = &chain;
+  Dwg_Header_Variables* _obj = &dwg->header_vars;
+
+  dat->version = (Dwg_Version_Type) dwg->header.version;
+
+  #include "header_variables.spec"
+}
+
+/* Release an object whose type is the class dwg->dwg_class[i].
+ */
+static void
+dwg_free_variable_type(Dwg_Data *dwg, Bit_Chain *dat, Dwg_Object *obj, int i)
+{
+  const char *dxfname = (const char *) dwg->dwg_class[i].dxfname;
+  unsigned int j;
+
+  if (!dxfname)
+    return;
+  for (j = 0; j < sizeof(dwg_class_free) / sizeof(dwg_class_free[0]); j++)
+    if (!strcmp(dxfname, dwg_class_free[j].dxfname))
+      {
+        dwg_class_free[j].free(dat, obj);
+        return;
+      }
+}
+
+/* Release the memory obj points to, except for its handle references.
+ */
+void
+dwg_free_object(Dwg_Object *obj)
+{
+  /* The spec skips a few bits by reading them; let it read zeros.  */
+  static unsigned char zeros[16];
+  Dwg_Data *dwg = obj->parent;
+  Bit_Chain chain;
+  Bit_Chain *dat = &chain;
+  int i;
+
+  if (obj->supertype == DWG_SUPERTYPE_UNKNOWN)
+    {
+      FREE_IF(obj->tio.unknown);
+      return;
+    }
+  if (obj->supertype == DWG_SUPERTYPE_UNDECODED)
+    return;
+  if (obj->supertype == DWG_SUPERTYPE_ENTITY ? !obj->tio.entity
+                                              : !obj->tio.object)
+    return;
+
+  chain.chain = zeros;
+  chain.size = sizeof(zeros);
+  chain.byte = 0;
+  chain.bit = 0;
+  chain.version = (Dwg_Version_Type) dwg->header.version;
+
+  if (obj->type <= DWG_TYPE_LAYOUT)
+    {
+      if (dwg_fixed_free[obj->type])
+        dwg_fixed_free[obj->type](dat, obj);
+    }
+  else
+    {
+      i = obj->type - 500;
+      if (obj->type >= 500 && i < (int) dwg->num_classes)
+        dwg_free_variable_type(dwg, dat, obj, i);
+    }
+
+  /* Every member of tio is a pointer to the struct of the type.  */
+  if (obj->supertype == DWG_SUPERTYPE_ENTITY)
+    {
+      Dwg_Object_Entity *ent = obj->tio.entity;
+
+      free(ent->tio.UNUSED);
+      free(ent->color.name);
+      free(ent->color.book_name);
+      free(ent->extended);
+      free(ent->picture);
+      free(ent->reactors);
+      FREE_IF(obj->tio.entity);
+    }
+  else
+    {
+      Dwg_Object_Object *ord = obj->tio.object;
+
+      free(ord->tio.DICTIONARY);
+      free(ord->extended);
+      FREE_IF(obj->tio.object);
+    }
+}
+
+#undef IS_FREE
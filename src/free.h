@@ -0,0 +1,31 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * free.h: prototypes of the functions releasing decoded data
+ */
+
+#ifndef FREE_H
+#define FREE_H
+
+#include "dwg.h"
+
+void
+dwg_free_object(Dwg_Object *obj);
+
+void
+dwg_free_header_vars(Dwg_Data *dwg);
+
+void
+dwg_free_xdata(Dwg_Resbuf *rbuf);
+
+#endif
@@ -25,6 +25,72 @@
 extern unsigned int
 bit_ckr8(unsigned int dx, unsigned char *adr, long n);
 
+/* Count the entries of an object map starting at dat->byte, without
+ * decoding any object, so that the object vector can be allocated once.
+ * dat itself is not moved.
+ */
+static long unsigned int
+count_object_map_entries(Bit_Chain *dat, long unsigned int maplasta)
+{
+  Bit_Chain map = *dat;
+  unsigned int section_size;
+  unsigned char sgdc[2];
+  long unsigned int duabyte;
+  long unsigned int previous_address = 0;
+  long unsigned int count = 0;
+
+  do
+    {
+      duabyte = map.byte;
+      sgdc[0] = bit_read_RC(&map);
+      sgdc[1] = bit_read_RC(&map);
+      section_size = (sgdc[0] << 8) | sgdc[1];
+      if (section_size > 2035)
+        break;
+
+      while (map.byte - duabyte < section_size)
+        {
+          previous_address = map.byte;
+          bit_read_MC(&map);
+          bit_read_MC(&map);
+          if (map.byte == previous_address)
+            break;
+          count++;
+        }
+      if (map.byte == previous_address)
+        break;
+
+      if (map.bit > 0)
+        {
+          map.byte += 1;
+          map.bit = 0;
+        }
+      map.byte += 2; // CRC
+
+      if (map.byte >= maplasta)
+        break;
+    }
+  while (section_size > 2);
+
+  return count;
+}
+
+/* Return nonzero if the lazy load or the read filter left objects of
+ * dwg undecoded: dwg_decode_lazy_object needs their chain then.
+ */
+static int
+objects_left_undecoded(Dwg_Data *dwg)
+{
+  long unsigned int i;
+
+  if (dwg->opts & DWG_OPT_LAZY)
+    return 1;
+  for (i = 0; i < dwg->num_objects; i++)
+    if (dwg->object[i].supertype == DWG_SUPERTYPE_UNDECODED)
+      return 1;
+  return 0;
+}
+
 /* Read R13-R15 Object-map Section
  */
 void
@@ -44,6 +110,7 @@ read_R13_R15_section_object_map(Bit_Chain *dat, Dwg_Data *dwg)
 
   maplasta = dat->byte + dwg->header.section[2].size; // 4
   dwg->num_objects = 0;
+  dwg_alloc_objects(dwg, dat, count_object_map_entries(dat, maplasta));
   object_begin = dat->size;
   object_end = 0;
   do
@@ -61,7 +128,7 @@ read_R13_R15_section_object_map(Bit_Chain *dat, Dwg_Data *dwg)
       if (section_size > 2035)
         {
           LOG_ERROR("Object-map section size greater than 2035!\n")
-          return -1;
+          break;
         }
 
       last_handle = 0;
@@ -116,13 +183,16 @@ read_R13_R15_section_object_map(Bit_Chain *dat, Dwg_Data *dwg)
       sgdc[1] = bit_read_RC(dat);
       ckr = (sgdc[0] << 8) | sgdc[1];
 
-      ckr2 = bit_ckr8(0xc0c1, dat->chain + duabyte, section_size);
+      ckr2 = ckr;
+      if (!(dwg->opts & DWG_OPT_NO_CRC))
+        ckr2 = bit_ckr8(0xc0c1, dat->chain + duabyte, section_size);
 
       if (ckr != ckr2)
         {
           printf("section %d crc todo ckr:%x ckr2:%x\n",
                   dwg->header.section[2].number, ckr, ckr2);
-          return -1;
+          dwg->stats.crc_failures++;
+          break;
         }
 
       if (dat->byte >= maplasta)
@@ -130,13 +200,43 @@ read_R13_R15_section_object_map(Bit_Chain *dat, Dwg_Data *dwg)
     }
   while (section_size > 2);
 
+  /* Also after a broken section: decode the objects it already added.  */
+  if (dwg->opts & DWG_OPT_THREADS)
+    dwg_decode_objects(dwg, dat);
+
+  dwg_alloc_objects(dwg, dat, dwg->num_objects);
   LOG_INFO("Num objects: %lu\n", dwg->num_objects)
   LOG_INFO("\n Object Data: %8X\n", (unsigned int) object_begin)
   dat->byte = object_end;
-  object_begin = bit_read_MS(dat);
+  size = bit_read_MS(dat);
+  size += dat->byte + 2;
+  if (size > dat->size)
+    size = dat->size;
+
+  LOG_INFO(" Object Data (end): %8X\n", (unsigned int) size)
 
-  LOG_INFO(" Object Data (end): %8X\n",
-           (unsigned int) (object_end + object_begin+ 2))
+  /* The objects are in the file itself.  The chain is kept if the loader
+   * owns it, else their bytes are copied out of it, at the same
+   * addresses: the caller may free its buffer as soon as the load
+   * returns.
+   */
+  if (objects_left_undecoded(dwg) && object_begin < size)
+    {
+      if (dwg->object_chain_owner != DWG_CHAIN_BORROWED)
+        {
+          dwg->object_chain = dat->chain;
+          dwg->object_chain_size = dat->size;
+        }
+      else if ((dwg->object_chain = (unsigned char *) malloc(size)))
+        {
+          memcpy(dwg->object_chain + object_begin, dat->chain + object_begin,
+                 size - object_begin);
+          dwg->object_chain_size = size;
+          dwg->object_chain_owner = DWG_CHAIN_MALLOCED;
+        }
+      else
+        LOG_ERROR("Out of memory keeping the objects left undecoded\n")
+    }
 
   /*
    dat->byte = dwg->header.section[2].address - 2;
@@ -195,6 +295,8 @@ read_2004_section_handles(Bit_Chain *dat, Dwg_Data *dwg)
 
   maplasta = hdl_dat.byte + hdl_dat.size;
   dwg->num_objects = 0;
+  dwg_alloc_objects(dwg, &hdl_dat,
+                    count_object_map_entries(&hdl_dat, maplasta));
 
   do
     {
@@ -239,10 +341,21 @@ read_2004_section_handles(Bit_Chain *dat, Dwg_Data *dwg)
     }
   while (section_size > 2);
 
+  dwg_alloc_objects(dwg, &obj_dat, dwg->num_objects);
   LOG_TRACE("\nNum objects: %lu\n", dwg->num_objects);
 
+  if (dwg->opts & DWG_OPT_THREADS)
+    dwg_decode_objects(dwg, &obj_dat);
+
   free(hdl_dat.chain);
-  free(obj_dat.chain);
+  if (objects_left_undecoded(dwg))
+    {
+      dwg->object_chain = obj_dat.chain;
+      dwg->object_chain_size = obj_dat.size;
+      dwg->object_chain_owner = DWG_CHAIN_MALLOCED;
+    }
+  else
+    free(obj_dat.chain);
 }
 
 
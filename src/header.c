@@ -61,13 +61,16 @@ read_R13_R15_section_header(Bit_Chain *dat, Dwg_Data *dwg)
               + dwg->header.section[0].size - 18;
   dat->bit = 0;
   ckr = bit_read_RS(dat);
-  ckr2 = bit_ckr8(0xc0c1, dat->chain + dwg->header.section[0].address
-                  + 16, dwg->header.section[0].size - 34);
+  ckr2 = ckr;
+  if (!(dwg->opts & DWG_OPT_NO_CRC))
+    ckr2 = bit_ckr8(0xc0c1, dat->chain + dwg->header.section[0].address
+                    + 16, dwg->header.section[0].size - 34);
 
   if (ckr != ckr2)
     {
       printf("section %d crc todo ckr:%x ckr2:%x\n",
               dwg->header.section[0].number, ckr, ckr2);
+      dwg->stats.crc_failures++;
       return -1;
     }
 }
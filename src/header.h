@@ -18,8 +18,8 @@
  * modified by Till Heuschmann
  */
 
-#ifndef _DWG_OBJECT_H_
-#define _DWG_OBJECT_H_
+#ifndef HEADER_H
+#define HEADER_H
 
 #include "config.h"
 #include <stdbool.h>
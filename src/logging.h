@@ -43,6 +43,15 @@
 #define DWG_LOGLEVEL DWG_LOGLEVEL_NONE //default loglevel
 #endif //ifndef LOGLEVEL
 
+#ifdef USE_TRACING
+/* The logging level of the read path: that of the decode the chain dat
+ * belongs to, set from LIBREDWG_TRACE.  It is the DWG_LOGLEVEL of the
+ * files of that path; without tracing theirs is DWG_LOGLEVEL_NONE, and
+ * the logging code is compiled out.
+ */
+#define DWG_DECODE_LOGLEVEL dat->context.loglevel
+#endif
+
 #define HANDLER fprintf
 #define OUTPUT stderr
 
@@ -52,9 +61,9 @@
           }
 
 #define LOG_ERROR(args...) \
-          if (DWG_LOGLEVEL > DWG_LOGLEVEL_ERROR) { \
-              HANDLER(OUTPUT, "ERROR: "); \
-              LOG(ERROR, args) \
+          if (DWG_LOGLEVEL >= DWG_LOGLEVEL_ERROR) { \
+            HANDLER(OUTPUT, "ERROR: "); \
+            HANDLER(OUTPUT, args); \
           }
 
 #define LOG_INFO(args...) LOG(INFO, args)
@@ -20,306 +20,213 @@
 
 #include "object.h"
 #include "decode.h"
+#include "resolve_pointers.h"
+#include "stats.h"
+#include "threads.h"
 #include "logging.h"
 #include "dwg.spec"
 #include "dwg.h"
 
-static unsigned int loglevel;
+/* The decoders above were compiled without logging; the rest logs at
+   the level of the read path.  */
+#ifdef USE_TRACING
+#undef DWG_LOGLEVEL
+#define DWG_LOGLEVEL DWG_DECODE_LOGLEVEL
+#endif
 
-//#define DWG_LOGLEVEL loglevel
+/* Set the allocated size of the object vector to count entries
+ * (never below the number of objects already decoded), for the decode
+ * of dat.
+ */
+int
+dwg_alloc_objects(Dwg_Data *dwg, Bit_Chain *dat, long unsigned int count)
+{
+  Dwg_Object *object;
 
-/* Decode object
+  if (count < dwg->num_objects)
+    count = dwg->num_objects;
+  if (count == dwg->num_alloced_objects)
+    return 0;
+  if (count == 0)
+    {
+      free(dwg->object);
+      dwg->object = 0;
+      dwg->num_alloced_objects = 0;
+      return 0;
+    }
+
+  object = (Dwg_Object *) realloc(dwg->object, count * sizeof(Dwg_Object));
+  if (!object)
+    {
+      LOG_ERROR("Out of memory allocating %lu objects\n", count)
+      return -1;
+    }
+  dwg->object = object;
+  dwg->num_alloced_objects = count;
+  dwg->stats.object_allocs++;
+
+  return 0;
+}
+
+typedef struct _class_decoder
+{
+  const char *dxfname;
+  Dwg_Object_Decoder decode;
+} Class_Decoder;
+
+#define FIXED_DECODER(type, token) [type] = DWG_DECODER(token),
+#define CLASS_DECODER(dxfname, token) { dxfname, DWG_DECODER(token) },
+
+/* Decoders of the objects of fixed type, indexed by type.
  */
-void
-dwg_decode_add_object(Dwg_Data *dwg, Bit_Chain *dat,
-                      long unsigned int address)
+static const Dwg_Object_Decoder dwg_fixed_decoder[DWG_TYPE_LAYOUT + 1] =
 {
-  long unsigned int previous_address;
-  long unsigned int object_address;
-  unsigned char previous_bit;
-  Dwg_Object *obj;
+  FIXED_DECODERS(FIXED_DECODER)
+};
 
-  /* Keep the previous address
-   */
-  previous_address = dat->byte;
-  previous_bit = dat->bit;
+/* Decoders of the objects of variable type, by class DXF name.
+ */
+static const Class_Decoder dwg_class_decoders[] =
+{
+  CLASS_DECODERS(CLASS_DECODER)
+};
 
-  /* Use the indicated address for the object
-   */
-  dat->byte = address;
-  dat->bit = 0;
+#ifdef USE_TRACING
 
-  /*
-   * Reserve memory space for objects
-   */
-  if (dwg->num_objects == 0)
-    dwg->object = (Dwg_Object *) malloc(sizeof(Dwg_Object));
-  else
-    dwg->object = (Dwg_Object *) realloc(dwg->object, (dwg->num_objects + 1)
-        * sizeof(Dwg_Object));
+/* The same decoders, logging every field: see object_trace.c.  They are
+ * used when the logging level is at least DWG_LOGLEVEL_TRACE, so that
+ * the others have no logging code at all.
+ */
+#define TRACED_PROTOTYPE(key, token) \
+  void dwg_decode_traced_##token(Bit_Chain *dat, Dwg_Object *obj);
+#define TRACED_FIXED_DECODER(type, token) [type] = dwg_decode_traced_##token,
+#define TRACED_CLASS_DECODER(dxfname, token) \
+  { dxfname, dwg_decode_traced_##token },
 
-  if (loglevel)
-      LOG_INFO("\n\n======================\nObject number: %lu",
-          dwg->num_objects)
+FIXED_DECODERS(TRACED_PROTOTYPE)
+CLASS_DECODERS(TRACED_PROTOTYPE)
 
-  obj = &dwg->object[dwg->num_objects];
-  obj->index = dwg->num_objects;
-  dwg->num_objects++;
+static const Dwg_Object_Decoder dwg_traced_fixed_decoder[DWG_TYPE_LAYOUT + 1] =
+{
+  FIXED_DECODERS(TRACED_FIXED_DECODER)
+};
+
+static const Class_Decoder dwg_traced_class_decoders[] =
+{
+  CLASS_DECODERS(TRACED_CLASS_DECODER)
+};
+
+#endif /* USE_TRACING */
+
+/* Return the decoder of the objects of the class named dxfname, or NULL
+ * if that class is not supported.  Called once per class, when the
+ * classes section is read from dat: the decoder traces if the logging
+ * level of that decode asks for it.
+ */
+Dwg_Object_Decoder
+dwg_class_decoder(Bit_Chain *dat, const char *dxfname)
+{
+  const Class_Decoder *decoders = dwg_class_decoders;
+  unsigned int i;
+
+  if (!dxfname)
+    return 0;
+#ifdef USE_TRACING
+  if (DWG_LOGLEVEL >= DWG_LOGLEVEL_TRACE)
+    decoders = dwg_traced_class_decoders;
+#endif
+  for (i = 0; i < sizeof(dwg_class_decoders) / sizeof(dwg_class_decoders[0]);
+       i++)
+    if (!strcmp(dxfname, decoders[i].dxfname))
+      return decoders[i].decode;
+  return 0;
+}
+
+/* Return nonzero if the read filter leaves obj undecoded.
+ */
+static int
+dwg_object_skipped(Dwg_Data *dwg, Dwg_Object *obj)
+{
+  if (!dwg->read_options || !(dwg->read_options->flags & DWG_OPT_FILTER))
+    return 0;
+  if (obj->type <= DWG_TYPE_LAYOUT)
+    return !DWG_FILTER_HAS_TYPE(dwg->read_options, obj->type);
+  if (obj->type >= 500 && obj->type - 500 < dwg->num_classes)
+    return dwg->dwg_class[obj->type - 500].skip;
+  return 1;
+}
+
+/* Decode obj from its address in dat.  If lazy is set, or the read
+ * filter leaves obj out, only its type, size and handle are read.
+ */
+static void
+decode_object(Dwg_Data *dwg, Bit_Chain *dat, Dwg_Object *obj, int lazy)
+{
+  const Dwg_Object_Decoder *fixed_decoder = dwg_fixed_decoder;
+  long unsigned int object_address;
+
+#ifdef USE_TRACING
+  if (DWG_LOGLEVEL >= DWG_LOGLEVEL_TRACE)
+    fixed_decoder = dwg_traced_fixed_decoder;
+#endif
+
+  dat->byte = obj->address;
+  dat->bit = 0;
 
   obj->handle.code = 0;
   obj->handle.size = 0;
   obj->handle.value = 0;
 
-  obj->parent = dwg;
   obj->size = bit_read_MS(dat);
   object_address = dat->byte;
-  ktl_lastaddress = dat->byte + obj->size; /* (calculate the bitsize) */
   obj->type = bit_read_BS(dat);
 
   LOG_INFO(" Type: %d\n", obj->type)
 
+  if (obj->type == DWG_TYPE_LAYER_CONTROL)
+    //set LAYER_CONTROL object - helps keep track of layers
+    obj->parent->layer_control = obj;
+
+  /* Left undecoded: keep the handle, so that references to the object
+   * still resolve, and its address to decode it later.
+   */
+  if (lazy || dwg_object_skipped(dwg, obj))
+    {
+      LOG_INFO("Object not decoded\n")
+
+      SINCE(R_2000)
+        {
+          bit_read_RL(dat);  // skip bitsize
+        }
+      bit_read_H(dat, &obj->handle);
+
+      obj->supertype = DWG_SUPERTYPE_UNDECODED;
+      obj->tio.unknown = 0;
+      return;
+    }
+
   /* Check the type of the object
    */
-  switch (obj->type)
+  if (obj->type <= DWG_TYPE_LAYOUT && fixed_decoder[obj->type])
+    fixed_decoder[obj->type](dat, obj);
+  else if (!dwg_decode_variable_type(dwg, dat, obj))
     {
-  case DWG_TYPE_TEXT:
-    dwg_decode_TEXT(dat, obj);
-    break;
-  case DWG_TYPE_ATTRIB:
-    dwg_decode_ATTRIB(dat, obj);
-    break;
-  case DWG_TYPE_ATTDEF:
-    dwg_decode_ATTDEF(dat, obj);
-    break;
-  case DWG_TYPE_BLOCK:
-    dwg_decode_BLOCK(dat, obj);
-    break;
-  case DWG_TYPE_ENDBLK:
-    dwg_decode_ENDBLK(dat, obj);
-    break;
-  case DWG_TYPE_SEQEND:
-    dwg_decode_SEQEND(dat, obj);
-    break;
-  case DWG_TYPE_INSERT:
-    dwg_decode_INSERT(dat, obj);
-    break;
-  case DWG_TYPE_MINSERT:
-    dwg_decode_MINSERT(dat, obj);
-    break;
-  case DWG_TYPE_VERTEX_2D:
-    dwg_decode_VERTEX_2D(dat, obj);
-    break;
-  case DWG_TYPE_VERTEX_3D:
-    dwg_decode_VERTEX_3D(dat, obj);
-    break;
-  case DWG_TYPE_VERTEX_MESH:
-    dwg_decode_VERTEX_MESH(dat, obj);
-    break;
-  case DWG_TYPE_VERTEX_PFACE:
-    dwg_decode_VERTEX_PFACE(dat, obj);
-    break;
-  case DWG_TYPE_VERTEX_PFACE_FACE:
-    dwg_decode_VERTEX_PFACE_FACE(dat, obj);
-    break;
-  case DWG_TYPE_POLYLINE_2D:
-    dwg_decode_POLYLINE_2D(dat, obj);
-    break;
-  case DWG_TYPE_POLYLINE_3D:
-    dwg_decode_POLYLINE_3D(dat, obj);
-    break;
-  case DWG_TYPE_ARC:
-    dwg_decode_ARC(dat, obj);
-    break;
-  case DWG_TYPE_CIRCLE:
-    dwg_decode_CIRCLE(dat, obj);
-    break;
-  case DWG_TYPE_LINE:
-    dwg_decode_LINE(dat, obj);
-    break;
-  case DWG_TYPE_DIMENSION_ORDINATE:
-    dwg_decode_DIMENSION_ORDINATE(dat, obj);
-    break;
-  case DWG_TYPE_DIMENSION_LINEAR:
-    dwg_decode_DIMENSION_LINEAR(dat, obj);
-    break;
-  case DWG_TYPE_DIMENSION_ALIGNED:
-    dwg_decode_DIMENSION_ALIGNED(dat, obj);
-    break;
-  case DWG_TYPE_DIMENSION_ANG3PT:
-    dwg_decode_DIMENSION_ANG3PT(dat, obj);
-    break;
-  case DWG_TYPE_DIMENSION_ANG2LN:
-    dwg_decode_DIMENSION_ANG2LN(dat, obj);
-    break;
-  case DWG_TYPE_DIMENSION_RADIUS:
-    dwg_decode_DIMENSION_RADIUS(dat, obj);
-    break;
-  case DWG_TYPE_DIMENSION_DIAMETER:
-    dwg_decode_DIMENSION_DIAMETER(dat, obj);
-    break;
-  case DWG_TYPE_POINT:
-    dwg_decode_POINT(dat, obj);
-    break;
-  case DWG_TYPE__3DFACE:
-    dwg_decode__3DFACE(dat, obj);
-    break;
-  case DWG_TYPE_POLYLINE_PFACE:
-    dwg_decode_POLYLINE_PFACE(dat, obj);
-    break;
-  case DWG_TYPE_POLYLINE_MESH:
-    dwg_decode_POLYLINE_MESH(dat, obj);
-    break;
-  case DWG_TYPE_SOLID:
-    dwg_decode_SOLID(dat, obj);
-    break;
-  case DWG_TYPE_TRACE:
-    dwg_decode_TRACE(dat, obj);
-    break;
-  case DWG_TYPE_SHAPE:
-    dwg_decode_SHAPE(dat, obj);
-    break;
-  case DWG_TYPE_VIEWPORT:
-    dwg_decode_VIEWPORT(dat, obj);
-    break;
-  case DWG_TYPE_ELLIPSE:
-    dwg_decode_ELLIPSE(dat, obj);
-    break;
-  case DWG_TYPE_SPLINE:
-    dwg_decode_SPLINE(dat, obj);
-    break;
-  case DWG_TYPE_REGION:
-    dwg_decode_REGION(dat, obj);
-    break;
-  case DWG_TYPE_3DSOLID:
-    dwg_decode__3DSOLID(dat, obj);
-    break;
-  case DWG_TYPE_BODY:
-    dwg_decode_BODY(dat, obj);
-    break;
-  case DWG_TYPE_RAY:
-    dwg_decode_RAY(dat, obj);
-    break;
-  case DWG_TYPE_XLINE:
-    dwg_decode_XLINE(dat, obj);
-    break;
-  case DWG_TYPE_DICTIONARY:
-    dwg_decode_DICTIONARY(dat, obj);
-    break;
-  case DWG_TYPE_MTEXT:
-    dwg_decode_MTEXT(dat, obj);
-    break;
-  case DWG_TYPE_LEADER:
-    dwg_decode_LEADER(dat, obj);
-    break;
-  case DWG_TYPE_TOLERANCE:
-    dwg_decode_TOLERANCE(dat, obj);
-    break;
-  case DWG_TYPE_MLINE:
-    dwg_decode_MLINE(dat, obj);
-    break;
-  case DWG_TYPE_BLOCK_CONTROL:
-    dwg_decode_BLOCK_CONTROL(dat, obj);
-    break;
-  case DWG_TYPE_BLOCK_HEADER:
-    dwg_decode_BLOCK_HEADER(dat, obj);
-    break;
-  case DWG_TYPE_LAYER_CONTROL:
-    //set LAYER_CONTROL object - helps keep track of layers
-    obj->parent->layer_control = obj;
-    dwg_decode_LAYER_CONTROL(dat, obj);
-    break;
-  case DWG_TYPE_LAYER:
-    dwg_decode_LAYER(dat, obj);
-    break;
-  case DWG_TYPE_SHAPEFILE_CONTROL:
-    dwg_decode_SHAPEFILE_CONTROL(dat, obj);
-    break;
-  case DWG_TYPE_SHAPEFILE:
-    dwg_decode_SHAPEFILE(dat, obj);
-    break;
-  case DWG_TYPE_LTYPE_CONTROL:
-    dwg_decode_LTYPE_CONTROL(dat, obj);
-    break;
-  case DWG_TYPE_LTYPE:
-    dwg_decode_LTYPE(dat, obj);
-    break;
-  case DWG_TYPE_VIEW_CONTROL:
-    dwg_decode_VIEW_CONTROL(dat, obj);
-    break;
-  case DWG_TYPE_VIEW:
-    dwg_decode_VIEW(dat, obj);
-    break;
-  case DWG_TYPE_UCS_CONTROL:
-    dwg_decode_UCS_CONTROL(dat, obj);
-    break;
-  case DWG_TYPE_UCS:
-    dwg_decode_UCS(dat, obj);
-    break;
-  case DWG_TYPE_VPORT_CONTROL:
-    dwg_decode_VPORT_CONTROL(dat, obj);
-    break;
-  case DWG_TYPE_VPORT:
-    dwg_decode_VPORT(dat, obj);
-    break;
-  case DWG_TYPE_APPID_CONTROL:
-    dwg_decode_APPID_CONTROL(dat, obj);
-    break;
-  case DWG_TYPE_APPID:
-    dwg_decode_APPID(dat, obj);
-    break;
-  case DWG_TYPE_DIMSTYLE_CONTROL:
-    dwg_decode_DIMSTYLE_CONTROL(dat, obj);
-    break;
-  case DWG_TYPE_DIMSTYLE:
-    dwg_decode_DIMSTYLE(dat, obj);
-    break;
-  case DWG_TYPE_VP_ENT_HDR_CONTROL:
-    dwg_decode_VP_ENT_HDR_CONTROL(dat, obj);
-    break;
-  case DWG_TYPE_VP_ENT_HDR:
-    dwg_decode_VP_ENT_HDR(dat, obj);
-    break;
-  case DWG_TYPE_GROUP:
-    dwg_decode_GROUP(dat, obj);
-    break;
-  case DWG_TYPE_MLINESTYLE:
-    dwg_decode_MLINESTYLE(dat, obj);
-    break;
-  case DWG_TYPE_LWPLINE:
-    dwg_decode_LWPLINE(dat, obj);
-    break;
-  case DWG_TYPE_HATCH:
-    dwg_decode_HATCH(dat, obj);
-    break;
-  case DWG_TYPE_XRECORD:
-    dwg_decode_XRECORD(dat, obj);
-    break;
-  case DWG_TYPE_PLACEHOLDER:
-    dwg_decode_PLACEHOLDER(dat, obj);
-    break;
-  case DWG_TYPE_LAYOUT:
-    dwg_decode_LAYOUT(dat, obj);
-    break;
-  default:
-    if (!dwg_decode_variable_type(dwg, dat, obj))
-      {
-        LOG_INFO("Object UNKNOWN:\n")
-
-        SINCE(R_2000)
-          {
-            bit_read_RL(dat);  // skip bitsize
-          }
-
-        if (!bit_read_H(dat, &obj->handle))
-          {
-            LOG_INFO("Object handle: %x.%x.%lx\n", 
-              obj->handle.code, obj->handle.size, obj->handle.value)
-          }
-
-        obj->supertype = DWG_SUPERTYPE_UNKNOWN;
-        obj->tio.unknown = (unsigned char*)malloc(obj->size);
-        memcpy(obj->tio.unknown, &dat->chain[object_address], obj->size);
-      }
+      LOG_INFO("Object UNKNOWN:\n")
+
+      SINCE(R_2000)
+        {
+          bit_read_RL(dat);  // skip bitsize
+        }
+
+      if (!bit_read_H(dat, &obj->handle))
+        {
+          LOG_INFO("Object handle: %x.%x.%lx\n", 
+            obj->handle.code, obj->handle.size, obj->handle.value)
+        }
+
+      obj->supertype = DWG_SUPERTYPE_UNKNOWN;
+      obj->tio.unknown = (unsigned char*)dwg_malloc(dwg, obj->size);
+      memcpy(obj->tio.unknown, &dat->chain[object_address], obj->size);
     }
 
   /*
@@ -330,6 +237,49 @@ dwg_decode_add_object(Dwg_Data *dwg, Bit_Chain *dat,
    fprintf (stderr, "End address:\t%10lu (calculated)\n", address + 2 + obj->size);
    }
    */
+}
+
+/* Decode object
+ */
+void
+dwg_decode_add_object(Dwg_Data *dwg, Bit_Chain *dat,
+                      long unsigned int address)
+{
+  long unsigned int previous_address;
+  unsigned char previous_bit;
+  Dwg_Object *obj;
+  double start;
+
+  /* Keep the previous address
+   */
+  previous_address = dat->byte;
+  previous_bit = dat->bit;
+
+  /*
+   * Reserve memory space for objects.  The object map readers size the
+   * vector up front; grow geometrically if that count was too low.
+   */
+  if (dwg->num_objects == dwg->num_alloced_objects)
+    {
+      if (dwg_alloc_objects(dwg, dat, dwg->num_alloced_objects
+                            ? 2 * dwg->num_alloced_objects : 64))
+        return;
+    }
+
+  LOG_INFO("\n\n======================\nObject number: %lu",
+      dwg->num_objects)
+
+  obj = &dwg->object[dwg->num_objects];
+  obj->index = dwg->num_objects;
+  dwg->num_objects++;
+
+  /* Use the indicated address for the object
+   */
+  obj->parent = dwg;
+  obj->address = address;
+  start = dwg_stats_clock(dwg);
+  decode_object(dwg, dat, obj, dwg->opts & (DWG_OPT_LAZY | DWG_OPT_THREADS));
+  dwg->stats.objects_time += dwg_stats_clock(dwg) - start;
 
   /* Register the previous addresses for return
    */
@@ -337,126 +287,225 @@ dwg_decode_add_object(Dwg_Data *dwg, Bit_Chain *dat,
   dat->bit = previous_bit;
 }
 
-/* OBJECTS */
-
-/* returns 1 if object could be decoded and 0 otherwise
+/* Decode obj, if a lazy load (or the read filter) left it undecoded.
+ * The handle references it brings in are resolved.  Returns 0 if obj
+ * is decoded, -1 if its data is no longer available.
  */
 int
-dwg_decode_variable_type(Dwg_Data * dwg, Bit_Chain * dat, Dwg_Object* obj)
+dwg_decode_lazy_object(Dwg_Data *dwg, Dwg_Object *obj)
 {
-  int i;
+  Bit_Chain dat;
+  long unsigned int i, num_refs;
 
-  if ((obj->type - 500) > dwg->num_classes)
+  if (obj->supertype != DWG_SUPERTYPE_UNDECODED)
     return 0;
+  if (!dwg->object_chain)
+    return -1;
 
-  i = obj->type - 500;
+  dat.chain = dwg->object_chain;
+  dat.size = dwg->object_chain_size;
+  dat.byte = 0;
+  dat.bit = 0;
+  dat.version = (Dwg_Version_Type) dwg->header.version;
+  dwg_decode_context(&dat.context);
 
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "DICTIONARYVAR"))
-    {
-      dwg_decode_DICTIONARYVAR(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "ACDBDICTIONARYWDFLT"))
-    {
-      dwg_decode_DICTIONARYWDLFT(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "HATCH"))
-    {
-      dwg_decode_HATCH(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "IDBUFFER"))
-    {
-      dwg_decode_IDBUFFER(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "IMAGE"))
-    {
-      dwg_decode_IMAGE(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "IMAGEDEF"))
-    {
-      dwg_decode_IMAGEDEF(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "IMAGEDEF_REACTOR"))
-    {
-      dwg_decode_IMAGEDEFREACTOR(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "LAYER_INDEX"))
-    {
-      dwg_decode_LAYER_INDEX(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "LAYOUT"))
-    {
-      dwg_decode_LAYOUT(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "LWPLINE"))
-    {
-      dwg_decode_LWPLINE(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "OLE2FRAME"))
-    {
-      dwg_decode_OLE2FRAME(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "ACDBPLACEHOLDER"))
-    {
-      dwg_decode_PLACEHOLDER(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "RASTERVARIABLES"))
-    {
-      dwg_decode_RASTERVARIABLES(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "SORTENTSTABLE"))
-    {
-      dwg_decode_SORTENTSTABLE(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "SPATIAL_FILTER"))
-    {
-      dwg_decode_SPATIAL_FILTER(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "SPATIAL_INDEX"))
-    {
-      dwg_decode_SPATIAL_INDEX(dat, obj);
-      return 1;
-    }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "VBA_PROJECT"))
+  num_refs = dwg->num_object_refs;
+  decode_object(dwg, &dat, obj, 0);
+  for (i = num_refs; i < dwg->num_object_refs; i++)
+    dwg->object_ref[i]->obj =
+      dwg_resolve_handle(dwg, dwg->object_ref[i]->absolute_ref);
+
+  return obj->supertype == DWG_SUPERTYPE_UNDECODED ? -1 : 0;
+}
+
+/* The objects are decoded in this many chunks per thread, so that the
+ * threads finishing early can take over the rest.  */
+#define CHUNKS_PER_THREAD 4
+
+/* A run of consecutive objects, decoded into a private copy of the
+ * drawing: whatever the decoder appends to (the object references, the
+ * entity count, the arena) is then the chunk's own.
+ */
+typedef struct _decode_chunk
+{
+  long unsigned int first;
+  long unsigned int last;
+  Dwg_Data shadow;
+} Decode_Chunk;
+
+typedef struct _decode_run
+{
+  Dwg_Data *dwg;
+  Bit_Chain *dat;
+  Decode_Chunk *chunk;
+} Decode_Run;
+
+/* Task decoding chunk i, with its own cursor in the object data.
+ */
+static void
+decode_chunk(void *data, unsigned int i)
+{
+  Decode_Run *run = (Decode_Run *) data;
+  Decode_Chunk *chunk = &run->chunk[i];
+  Bit_Chain dat = *run->dat;
+  Dwg_Object *obj;
+  long unsigned int j;
+
+  for (j = chunk->first; j < chunk->last; j++)
     {
-//TODO:      dwg_decode_VBA_PROJECT(dat, obj);
-      return 0;
+      obj = &run->dwg->object[j];
+      obj->parent = &chunk->shadow;
+      decode_object(&chunk->shadow, &dat, obj, 0);
+      obj->parent = run->dwg;
     }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "WIPEOUTVARIABLE"))
+}
+
+/* Append what the decoding of a chunk of dat added to shadow to dwg.
+ */
+static void
+merge_chunk(Dwg_Data *dwg, Bit_Chain *dat, Dwg_Data *shadow)
+{
+  long unsigned int num_refs;
+  Dwg_Object_Ref **refs = 0;
+
+  if (shadow->num_object_refs)
     {
-//TODO:      dwg_decode_WIPEOUTVARIABLE(dat, obj);
-      return 0;
+      /* Keep the vector a whole number of REFS_PER_REALLOC entries,
+         as dwg_decode_handleref expects.  */
+      num_refs = dwg->num_object_refs + shadow->num_object_refs;
+      refs = (Dwg_Object_Ref **) realloc(dwg->object_ref,
+          (num_refs + REFS_PER_REALLOC - 1) / REFS_PER_REALLOC
+          * REFS_PER_REALLOC * sizeof(Dwg_Object_Ref *));
+      if (refs)
+        {
+          memcpy(refs + dwg->num_object_refs, shadow->object_ref,
+              shadow->num_object_refs * sizeof(Dwg_Object_Ref *));
+          dwg->object_ref = refs;
+          dwg->num_object_refs = num_refs;
+        }
+      else
+        LOG_ERROR("Out of memory merging %lu object references\n",
+            num_refs)
     }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "XRECORD"))
+
+  dwg->num_entities += shadow->num_entities;
+  dwg->stats.allocs += shadow->stats.allocs;
+  dwg->stats.alloc_bytes += shadow->stats.alloc_bytes;
+  if (shadow->layer_control)
+    dwg->layer_control = shadow->layer_control;
+  if (shadow->arena)
+    dwg_arena_merge(dwg->arena, shadow->arena);
+  shadow->arena = 0;
+}
+
+/* Decode the objects registered by the object map pass on num_threads
+ * threads, each with its own cursor in dat.  Returns -1 if the chunks
+ * could not be set up, leaving the objects undecoded.
+ */
+static int
+decode_objects_threaded(Dwg_Data *dwg, Bit_Chain *dat,
+                        unsigned int num_threads)
+{
+  Decode_Run run;
+  unsigned int i, num_chunks;
+  long unsigned int per_chunk;
+  int error = 0;
+
+  num_chunks = num_threads * CHUNKS_PER_THREAD;
+  if (num_chunks > dwg->num_objects)
+    num_chunks = dwg->num_objects;
+  per_chunk = (dwg->num_objects + num_chunks - 1) / num_chunks;
+  num_chunks = (dwg->num_objects + per_chunk - 1) / per_chunk;
+
+  run.chunk = (Decode_Chunk *) calloc(num_chunks, sizeof(Decode_Chunk));
+  if (!run.chunk)
+    return -1;
+  for (i = 0; i < num_chunks; i++)
     {
-      dwg_decode_XRECORD(dat, obj);
-      return 1;
+      Dwg_Data *shadow = &run.chunk[i].shadow;
+
+      run.chunk[i].first = i * per_chunk;
+      run.chunk[i].last = (i + 1) * per_chunk;
+      if (run.chunk[i].last > dwg->num_objects)
+        run.chunk[i].last = dwg->num_objects;
+      *shadow = *dwg;
+      shadow->object_ref = 0;
+      shadow->num_object_refs = 0;
+      shadow->num_entities = 0;
+      shadow->layer_control = 0;
+      memset(&shadow->stats, 0, sizeof(Dwg_Load_Stats));
+      if (dwg->arena)
+        {
+          shadow->arena = dwg_arena_new();
+          if (!shadow->arena)
+            error = -1;
+        }
     }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "DIMASSOC"))
+
+  run.dwg = dwg;
+  run.dat = dat;
+  if (!error)
+    error = dwg_run_tasks(decode_chunk, &run, num_chunks, num_threads);
+
+  /* In file order, as if decoded one after the other.  */
+  for (i = 0; i < num_chunks; i++)
     {
-//TODO:      dwg_decode_DIMASSOC(dat, obj);
-      return 0;
+      if (!error)
+        merge_chunk(dwg, dat, &run.chunk[i].shadow);
+      free(run.chunk[i].shadow.object_ref);
+      dwg_arena_destroy(run.chunk[i].shadow.arena);
     }
-  if (!strcmp((const char *)dwg->dwg_class[i].dxfname, "MATERIAL"))
+  free(run.chunk);
+  return error;
+}
+
+/* Decode the objects registered by a DWG_OPT_THREADS object map pass,
+ * whose data is in dat.  Without thread support, or for a handful of
+ * objects, they are decoded here one after the other.
+ */
+void
+dwg_decode_objects(Dwg_Data *dwg, Bit_Chain *dat)
+{
+  long unsigned int previous_address = dat->byte;
+  unsigned char previous_bit = dat->bit;
+  unsigned int num_threads;
+  long unsigned int i;
+  double start;
+
+  if (dwg->opts & DWG_OPT_LAZY)
+    return;
+
+  start = dwg_stats_clock(dwg);
+  num_threads = dwg_num_threads(dwg);
+  if (num_threads > dwg->num_objects / 16)
+    num_threads = dwg->num_objects / 16;
+  if (num_threads <= 1 || decode_objects_threaded(dwg, dat, num_threads))
     {
-//TODO:      dwg_decode_MATERIAL(dat, obj);
-      return 0;
+      for (i = 0; i < dwg->num_objects; i++)
+        if (dwg->object[i].supertype == DWG_SUPERTYPE_UNDECODED)
+          decode_object(dwg, dat, &dwg->object[i], 0);
+      dat->byte = previous_address;
+      dat->bit = previous_bit;
     }
-
-  return 0;
+  dwg->stats.objects_time += dwg_stats_clock(dwg) - start;
 }
 
+/* OBJECTS */
+
+/* returns 1 if object could be decoded and 0 otherwise
+ */
+int
+dwg_decode_variable_type(Dwg_Data * dwg, Bit_Chain * dat, Dwg_Object* obj)
+{
+  Dwg_Class *klass;
+
+  if (obj->type < 500 || obj->type - 500 >= dwg->num_classes)
+    return 0;
+
+  klass = &dwg->dwg_class[obj->type - 500];
+  if (!klass->decode)
+    return 0;
+
+  klass->decode(dat, obj);
+  return 1;
+}
@@ -18,8 +18,8 @@
  * modified by Till Heuschmann
  */
 
-#ifndef _DWG_OBJECT_H_
-#define _DWG_OBJECT_H_
+#ifndef OBJECT_H
+#define OBJECT_H
 
 #include "config.h"
 #include <stdbool.h>
@@ -32,14 +32,126 @@
 #include "bits.h"
 #include "print.h"
 
-long unsigned int ktl_lastaddress;
+/* The objects of fixed type that have a decoder: X(type, token) for
+ * each, whose decoder is DWG_DECODER(token).  free.c releases the same
+ * types.
+ */
+#define FIXED_DECODERS(X) \
+  X(DWG_TYPE_TEXT,               TEXT) \
+  X(DWG_TYPE_ATTRIB,             ATTRIB) \
+  X(DWG_TYPE_ATTDEF,             ATTDEF) \
+  X(DWG_TYPE_BLOCK,              BLOCK) \
+  X(DWG_TYPE_ENDBLK,             ENDBLK) \
+  X(DWG_TYPE_SEQEND,             SEQEND) \
+  X(DWG_TYPE_INSERT,             INSERT) \
+  X(DWG_TYPE_MINSERT,            MINSERT) \
+  X(DWG_TYPE_VERTEX_2D,          VERTEX_2D) \
+  X(DWG_TYPE_VERTEX_3D,          VERTEX_3D) \
+  X(DWG_TYPE_VERTEX_MESH,        VERTEX_MESH) \
+  X(DWG_TYPE_VERTEX_PFACE,       VERTEX_PFACE) \
+  X(DWG_TYPE_VERTEX_PFACE_FACE,  VERTEX_PFACE_FACE) \
+  X(DWG_TYPE_POLYLINE_2D,        POLYLINE_2D) \
+  X(DWG_TYPE_POLYLINE_3D,        POLYLINE_3D) \
+  X(DWG_TYPE_ARC,                ARC) \
+  X(DWG_TYPE_CIRCLE,             CIRCLE) \
+  X(DWG_TYPE_LINE,               LINE) \
+  X(DWG_TYPE_DIMENSION_ORDINATE, DIMENSION_ORDINATE) \
+  X(DWG_TYPE_DIMENSION_LINEAR,   DIMENSION_LINEAR) \
+  X(DWG_TYPE_DIMENSION_ALIGNED,  DIMENSION_ALIGNED) \
+  X(DWG_TYPE_DIMENSION_ANG3PT,   DIMENSION_ANG3PT) \
+  X(DWG_TYPE_DIMENSION_ANG2LN,   DIMENSION_ANG2LN) \
+  X(DWG_TYPE_DIMENSION_RADIUS,   DIMENSION_RADIUS) \
+  X(DWG_TYPE_DIMENSION_DIAMETER, DIMENSION_DIAMETER) \
+  X(DWG_TYPE_POINT,              POINT) \
+  X(DWG_TYPE__3DFACE,            _3DFACE) \
+  X(DWG_TYPE_POLYLINE_PFACE,     POLYLINE_PFACE) \
+  X(DWG_TYPE_POLYLINE_MESH,      POLYLINE_MESH) \
+  X(DWG_TYPE_SOLID,              SOLID) \
+  X(DWG_TYPE_TRACE,              TRACE) \
+  X(DWG_TYPE_SHAPE,              SHAPE) \
+  X(DWG_TYPE_VIEWPORT,           VIEWPORT) \
+  X(DWG_TYPE_ELLIPSE,            ELLIPSE) \
+  X(DWG_TYPE_SPLINE,             SPLINE) \
+  X(DWG_TYPE_REGION,             REGION) \
+  X(DWG_TYPE_3DSOLID,            _3DSOLID) \
+  X(DWG_TYPE_BODY,               BODY) \
+  X(DWG_TYPE_RAY,                RAY) \
+  X(DWG_TYPE_XLINE,              XLINE) \
+  X(DWG_TYPE_DICTIONARY,         DICTIONARY) \
+  X(DWG_TYPE_MTEXT,              MTEXT) \
+  X(DWG_TYPE_LEADER,             LEADER) \
+  X(DWG_TYPE_TOLERANCE,          TOLERANCE) \
+  X(DWG_TYPE_MLINE,              MLINE) \
+  X(DWG_TYPE_BLOCK_CONTROL,      BLOCK_CONTROL) \
+  X(DWG_TYPE_BLOCK_HEADER,       BLOCK_HEADER) \
+  X(DWG_TYPE_LAYER_CONTROL,      LAYER_CONTROL) \
+  X(DWG_TYPE_LAYER,              LAYER) \
+  X(DWG_TYPE_SHAPEFILE_CONTROL,  SHAPEFILE_CONTROL) \
+  X(DWG_TYPE_SHAPEFILE,          SHAPEFILE) \
+  X(DWG_TYPE_LTYPE_CONTROL,      LTYPE_CONTROL) \
+  X(DWG_TYPE_LTYPE,              LTYPE) \
+  X(DWG_TYPE_VIEW_CONTROL,       VIEW_CONTROL) \
+  X(DWG_TYPE_VIEW,               VIEW) \
+  X(DWG_TYPE_UCS_CONTROL,        UCS_CONTROL) \
+  X(DWG_TYPE_UCS,                UCS) \
+  X(DWG_TYPE_VPORT_CONTROL,      VPORT_CONTROL) \
+  X(DWG_TYPE_VPORT,              VPORT) \
+  X(DWG_TYPE_APPID_CONTROL,      APPID_CONTROL) \
+  X(DWG_TYPE_APPID,              APPID) \
+  X(DWG_TYPE_DIMSTYLE_CONTROL,   DIMSTYLE_CONTROL) \
+  X(DWG_TYPE_DIMSTYLE,           DIMSTYLE) \
+  X(DWG_TYPE_VP_ENT_HDR_CONTROL, VP_ENT_HDR_CONTROL) \
+  X(DWG_TYPE_VP_ENT_HDR,         VP_ENT_HDR) \
+  X(DWG_TYPE_GROUP,              GROUP) \
+  X(DWG_TYPE_MLINESTYLE,         MLINESTYLE) \
+  X(DWG_TYPE_LWPLINE,            LWPLINE) \
+  X(DWG_TYPE_HATCH,              HATCH) \
+  X(DWG_TYPE_XRECORD,            XRECORD) \
+  X(DWG_TYPE_PLACEHOLDER,        PLACEHOLDER) \
+  X(DWG_TYPE_LAYOUT,             LAYOUT)
+
+/* The classes of objects that have a decoder: X(dxfname, token) for each.
+ * TODO: VBA_PROJECT, WIPEOUTVARIABLE, DIMASSOC, MATERIAL
+ */
+#define CLASS_DECODERS(X) \
+  X("DICTIONARYVAR",       DICTIONARYVAR) \
+  X("ACDBDICTIONARYWDFLT", DICTIONARYWDLFT) \
+  X("HATCH",               HATCH) \
+  X("IDBUFFER",            IDBUFFER) \
+  X("IMAGE",               IMAGE) \
+  X("IMAGEDEF",            IMAGEDEF) \
+  X("IMAGEDEF_REACTOR",    IMAGEDEFREACTOR) \
+  X("LAYER_INDEX",         LAYER_INDEX) \
+  X("LAYOUT",              LAYOUT) \
+  X("LWPLINE",             LWPLINE) \
+  X("OLE2FRAME",           OLE2FRAME) \
+  X("ACDBPLACEHOLDER",     PLACEHOLDER) \
+  X("RASTERVARIABLES",     RASTERVARIABLES) \
+  X("SORTENTSTABLE",       SORTENTSTABLE) \
+  X("SPATIAL_FILTER",      SPATIAL_FILTER) \
+  X("SPATIAL_INDEX",       SPATIAL_INDEX) \
+  X("XRECORD",             XRECORD)
+
+typedef void (*Dwg_Object_Decoder) (Bit_Chain *dat, Dwg_Object *obj);
+
+Dwg_Object_Decoder
+dwg_class_decoder(Bit_Chain *dat, const char *dxfname);
 
 int
 dwg_decode_variable_type(Dwg_Data *dwg, Bit_Chain *dat,
                          Dwg_Object *obj);
 
+int
+dwg_alloc_objects(Dwg_Data *dwg, Bit_Chain *dat, long unsigned int count);
+
 void
 dwg_decode_add_object(Dwg_Data *dwg, Bit_Chain *dat,
                       long unsigned int address);
 
+int
+dwg_decode_lazy_object(Dwg_Data *dwg, Dwg_Object *obj);
+
+void
+dwg_decode_objects(Dwg_Data *dwg, Bit_Chain *dat);
+
 #endif
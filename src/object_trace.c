@@ -0,0 +1,36 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * object_trace.c: the decoders of the objects, logging every field
+ *
+ * With tracing (--enable-trace), the specs are compiled a second time
+ * here, at the logging level of the read path, under the names
+ * dwg_decode_traced_*.  object.c picks them when that level is at least
+ * DWG_LOGLEVEL_TRACE: its own decoders are compiled without any logging
+ * code.  Without tracing, this file is empty.
+ */
+
+#include "config.h"
+
+#ifdef USE_TRACING
+
+#define DWG_DECODER(token) dwg_decode_traced_##token
+#define decode_3dsolid decode_3dsolid_traced
+#define DWG_LOGLEVEL DWG_DECODE_LOGLEVEL
+
+#include "object.h"
+#include "decode.h"
+#include "logging.h"
+#include "dwg.spec"
+
+#endif /* USE_TRACING */
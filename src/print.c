@@ -86,6 +86,7 @@
     }
 
 #define FIELD_VECTOR(name, type, size) FIELD_VECTOR_N(name, type, _obj->size)
+#define FIELD_VECTOR_T(name, size) FIELD_VECTOR_N(name, TV, _obj->size)
 
 #define FIELD_2RD_VECTOR(name, size)\
   for (vcount=0; vcount< _obj->size; vcount++)\
@@ -185,6 +186,9 @@ dwg_print_object(Dwg_Object *obj)
 {
   Bit_Chain * dat = (Bit_Chain *)obj->parent->bit_chain;
 
+  if (obj->supertype == DWG_SUPERTYPE_UNDECODED)
+    return;
+
   switch (obj->type)
     {
   case DWG_TYPE_TEXT:
@@ -22,12 +22,71 @@
 #include "resolve_pointers.h"
 #include "logging.h"
 #include "decode.h"
+#include "stats.h"
+
+static int
+compare_handle_index(const void *a, const void *b)
+{
+  const Dwg_Handle_Index *ha = (const Dwg_Handle_Index *) a;
+  const Dwg_Handle_Index *hb = (const Dwg_Handle_Index *) b;
+
+  if (ha->handle != hb->handle)
+    return ha->handle < hb->handle ? -1 : 1;
+  /* Keep duplicates in object order, so the first one wins.  */
+  if (ha->index != hb->index)
+    return ha->index < hb->index ? -1 : 1;
+  return 0;
+}
+
+/**
+ * Build the handle index of dwg: all object handles sorted by value.
+ * The object map is usually already sorted by handle, in which case
+ * the index is filled in a single pass without sorting.
+ */
+int
+dwg_build_handle_index(Dwg_Data * dwg)
+{
+  long unsigned int i;
+  int sorted = 1;
+
+  if (dwg->handle_index)
+    free(dwg->handle_index);
+  dwg->handle_index = 0;
+  dwg->num_handle_index = 0;
+  if (dwg->num_objects == 0)
+    return 0;
+
+  dwg->handle_index = (Dwg_Handle_Index *) malloc(dwg->num_objects
+      * sizeof(Dwg_Handle_Index));
+  if (!dwg->handle_index)
+    {
+      LOG_ERROR("Out of memory building the handle index\n")
+      return -1;
+    }
+  for (i = 0; i < dwg->num_objects; i++)
+    {
+      dwg->handle_index[i].handle = dwg->object[i].handle.value;
+      dwg->handle_index[i].index = i;
+      if (i > 0 && dwg->handle_index[i].handle
+          < dwg->handle_index[i - 1].handle)
+        sorted = 0;
+    }
+  if (!sorted)
+    qsort(dwg->handle_index, dwg->num_objects, sizeof(Dwg_Handle_Index),
+        compare_handle_index);
+  dwg->num_handle_index = dwg->num_objects;
+
+  return 0;
+}
 
 void
 resolve_objectref_vector(Dwg_Data * dwg)
 {
   long unsigned int i;
   Dwg_Object * obj;
+  double start = dwg_stats_clock(dwg);
+
+  dwg_build_handle_index(dwg);
   for (i = 0; i < dwg->num_object_refs; i++)
     {
       LOG_TRACE("\n==========\n")
@@ -50,6 +109,10 @@ resolve_objectref_vector(Dwg_Data * dwg)
 
       //assign found pointer to objectref vector
       dwg->object_ref[i]->obj = obj;
+      if (obj)
+        dwg->stats.refs_resolved++;
+      else if (dwg->object_ref[i]->absolute_ref)
+        dwg->stats.refs_unresolved++;
 
 
       if (DWG_LOGLEVEL >= DWG_LOGLEVEL_INSANE)
@@ -60,6 +123,7 @@ resolve_objectref_vector(Dwg_Data * dwg)
             LOG_ERROR("Null object pointer: object_ref[%lu]\n", i)
         }
     }
+  dwg->stats.resolve_time += dwg_stats_clock(dwg) - start;
 }
 
 /**
@@ -68,8 +132,29 @@ resolve_objectref_vector(Dwg_Data * dwg)
 Dwg_Object *
 dwg_resolve_handle(Dwg_Data* dwg, long unsigned int absref)
 {
-  //FIXME find a faster algorithm
   long unsigned int i;
+
+  /* Binary search for the first entry with this handle.  */
+  if (dwg->handle_index && dwg->num_handle_index == dwg->num_objects)
+    {
+      long unsigned int lo = 0, hi = dwg->num_handle_index;
+
+      while (lo < hi)
+        {
+          long unsigned int mid = lo + (hi - lo) / 2;
+
+          if (dwg->handle_index[mid].handle < absref)
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+      if (lo < dwg->num_handle_index && dwg->handle_index[lo].handle == absref)
+        return &dwg->object[dwg->handle_index[lo].index];
+      LOG_ERROR("Object not found: %lu\n", absref)
+      return 0;
+    }
+
+  /* No index (yet): fall back to a linear scan.  */
   for (i = 0; i < dwg->num_objects; i++)
     {
       if (dwg->object[i].handle.value == absref)
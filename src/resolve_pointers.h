@@ -18,8 +18,8 @@
  * modified by Till Heuschmann
  */
 
-#ifndef _DWG_OBJECT_H_
-#define _DWG_OBJECT_H_
+#ifndef RESOLVE_POINTERS_H
+#define RESOLVE_POINTERS_H
 
 #include "config.h"
 #include <stdbool.h>
@@ -33,6 +33,9 @@
 #include "dwg.h"
 #include "print.h"
 
+int
+dwg_build_handle_index(Dwg_Data * dwg);
+
 void
 resolve_objectref_vector(Dwg_Data * dwg);
 
@@ -56,15 +56,19 @@ read_R13_R15_section_locate(Bit_Chain *dat, Dwg_Data *dwg)
     }
 
   // Check CRC-on
-  ckr = bit_ckr8(0xc0c1, dat->chain, dat->byte);
-  ckr2 = bit_read_RS(dat);
+  ckr = bit_read_RS(dat);
+  ckr2 = ckr;
+  if (!(dwg->opts & DWG_OPT_NO_CRC))
+    ckr2 = bit_ckr8(0xc0c1, dat->chain, dat->byte - 2);
   if (ckr != ckr2)
     {
       printf("header crc todo ckr:%x ckr2:%x\n", ckr, ckr2);
+      dwg->stats.crc_failures++;
       return 1;
     }
 
-  if (bit_search_sentinel(dat, dwg_sentinel(DWG_SENTINEL_HEADER_END)))
+  if (bit_search_sentinel_range(dat, dwg_sentinel(DWG_SENTINEL_HEADER_END),
+                                dat->byte, dat->size))
     LOG_TRACE("\n HEADER (end): %8X\n", (unsigned int) dat->byte)
 }
 
@@ -91,7 +95,8 @@ read_R2004_section_map(Bit_Chain *dat, Dwg_Data *dwg,
   if (decomp == 0)
     return;                // No memory
 
-  decompress_R2004_section(dat, decomp, comp_data_size);
+  decompress_R2004_section(dat, decomp, decomp_data_size, comp_data_size);
+  dwg->stats.bytes_decompressed += decomp_data_size;
   LOG_TRACE("\n 2004 Section Map fields \n")
 
   section_address = 0x100;  // starting address
@@ -18,8 +18,8 @@
  * modified by Till Heuschmann
  */
 
-#ifndef _DWG_OBJECT_H_
-#define _DWG_OBJECT_H_
+#ifndef SECTION_LOCATE_H
+#define SECTION_LOCATE_H
 
 #include "config.h"
 #include <stdbool.h>
@@ -0,0 +1,82 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * stats.c: the statistics of a load (Dwg_Load_Stats)
+ *
+ * The decoder times a phase by the difference of dwg_stats_clock at its
+ * end and at its start, which is 0 without DWG_OPT_STATS, so that the
+ * clock is only read when asked for.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "stats.h"
+
+/* Seconds of the monotonic clock, or of the time of day without one.
+ */
+double
+dwg_clock(void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+#endif
+  struct timeval tv;
+
+#ifdef CLOCK_MONOTONIC
+  if (!clock_gettime(CLOCK_MONOTONIC, &ts))
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* Seconds of dwg_clock, if dwg is loaded with DWG_OPT_STATS, else 0.
+ */
+double
+dwg_stats_clock(Dwg_Data *dwg)
+{
+  if (!(dwg->opts & DWG_OPT_STATS))
+    return 0;
+  return dwg_clock();
+}
+
+/* Count the objects of dwg by type, once loaded.
+ */
+void
+dwg_stats_count_objects(Dwg_Data *dwg)
+{
+  long unsigned int i;
+
+  memset(dwg->stats.objects_by_type, 0, sizeof(dwg->stats.objects_by_type));
+  dwg->stats.class_objects = 0;
+  for (i = 0; i < dwg->num_objects; i++)
+    if (dwg->object[i].type <= DWG_TYPE_LAYOUT)
+      dwg->stats.objects_by_type[dwg->object[i].type]++;
+    else
+      dwg->stats.class_objects++;
+}
+
+/* Copy the statistics of the last load of dwg to stats.  Returns -1 if
+ * either is NULL.
+ */
+int
+dwg_get_load_stats(Dwg_Data *dwg, Dwg_Load_Stats *stats)
+{
+  if (!dwg || !stats)
+    return -1;
+  *stats = dwg->stats;
+  return 0;
+}
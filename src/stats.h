@@ -0,0 +1,31 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * stats.h: the statistics of a load (Dwg_Load_Stats)
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "dwg.h"
+
+double
+dwg_clock(void);
+
+double
+dwg_stats_clock(Dwg_Data *dwg);
+
+void
+dwg_stats_count_objects(Dwg_Data *dwg);
+
+#endif
@@ -0,0 +1,138 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * threads.c: running independent tasks of the decoder, the encoder and the
+ * batch loader on several threads
+ *
+ * A task is a function called with an index; the tasks of one run are
+ * taken by the threads in index order, one at a time, so that threads
+ * done early take over the rest.  Without thread support, the tasks
+ * are simply run in order.
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include "threads.h"
+
+/* Number of processors online, or 1 if unknown.
+ */
+unsigned int
+dwg_num_processors(void)
+{
+  long int num_processors = 1;
+
+#if defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+  num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return num_processors > 0 ? num_processors : 1;
+}
+
+/* Number of threads for the decoding or encoding of dwg: with
+ * DWG_OPT_THREADS, as set in its read options while it is read, and one
+ * per processor after (or if the read options say 0); else 1.
+ */
+unsigned int
+dwg_num_threads(Dwg_Data *dwg)
+{
+  unsigned int num_threads = 0;
+
+  if (!(dwg->opts & DWG_OPT_THREADS))
+    return 1;
+  if (dwg->read_options)
+    num_threads = dwg->read_options->num_threads;
+  return num_threads ? num_threads : dwg_num_processors();
+}
+
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD)
+
+typedef struct _dwg_task_pool
+{
+  Dwg_Task task;
+  void *data;
+  unsigned int num_tasks;
+  unsigned int next_task;
+  pthread_mutex_t lock;
+} Dwg_Task_Pool;
+
+static void *
+task_worker(void *arg)
+{
+  Dwg_Task_Pool *pool = (Dwg_Task_Pool *) arg;
+  unsigned int i;
+
+  for (;;)
+    {
+      pthread_mutex_lock(&pool->lock);
+      i = pool->next_task;
+      if (i < pool->num_tasks)
+        pool->next_task++;
+      pthread_mutex_unlock(&pool->lock);
+      if (i >= pool->num_tasks)
+        return 0;
+      pool->task(pool->data, i);
+    }
+}
+
+#endif /* HAVE_PTHREAD_H && HAVE_PTHREAD */
+
+/* Call task(data, i) for every i below num_tasks, on up to num_threads
+ * threads, the calling one included, and return when all calls have
+ * returned.  Returns -1, with no task run, if out of memory.
+ */
+int
+dwg_run_tasks(Dwg_Task task, void *data, unsigned int num_tasks,
+              unsigned int num_threads)
+{
+  unsigned int i;
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD)
+  Dwg_Task_Pool pool;
+  pthread_t *thread;
+  unsigned int started;
+
+  if (num_threads > num_tasks)
+    num_threads = num_tasks;
+  if (num_threads > 1)
+    {
+      thread = (pthread_t *) malloc((num_threads - 1) * sizeof(pthread_t));
+      if (!thread)
+        return -1;
+      pool.task = task;
+      pool.data = data;
+      pool.num_tasks = num_tasks;
+      pool.next_task = 0;
+      pthread_mutex_init(&pool.lock, 0);
+      /* The calling thread is one of them, so threads failing to start
+         only slow the run down.  */
+      for (started = 0; started < num_threads - 1; started++)
+        if (pthread_create(&thread[started], 0, task_worker, &pool))
+          break;
+      task_worker(&pool);
+      for (i = 0; i < started; i++)
+        pthread_join(thread[i], 0);
+      pthread_mutex_destroy(&pool.lock);
+      free(thread);
+      return 0;
+    }
+#endif /* HAVE_PTHREAD_H && HAVE_PTHREAD */
+
+  for (i = 0; i < num_tasks; i++)
+    task(data, i);
+  return 0;
+}
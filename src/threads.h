@@ -0,0 +1,35 @@
+/*****************************************************************************/
+/*  LibreDWG - free implementation of the DWG file format                    */
+/*                                                                           */
+/*  Copyright (C) 2010 Free Software Foundation, Inc.                        */
+/*                                                                           */
+/*  This library is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * threads.h: running independent tasks of the decoder, the encoder and the
+ * batch loader on several threads
+ */
+
+#ifndef THREADS_H
+#define THREADS_H
+
+#include "dwg.h"
+
+typedef void (*Dwg_Task) (void *data, unsigned int i);
+
+unsigned int
+dwg_num_processors(void);
+
+unsigned int
+dwg_num_threads(Dwg_Data *dwg);
+
+int
+dwg_run_tasks(Dwg_Task task, void *data, unsigned int num_tasks,
+              unsigned int num_threads);
+
+#endif